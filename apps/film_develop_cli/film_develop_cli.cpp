@@ -0,0 +1,112 @@
+// Develop batches of images with film scan textures.
+// Every image is developed K times with a texture, blend mode and opacity drawn from a seed per
+// (image, variant); the run is recorded in a manifest that --replay regenerates exactly.
+
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "film_develop.hpp"
+#include "util/Blend.hpp"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+bool isImageFile(const fs::path& p) {
+    std::string ext = p.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return char(std::tolower(c)); });
+    return ext == ".jpg" || ext == ".jpeg" || ext == ".png" || ext == ".webp" || ext == ".bmp" ||
+           ext == ".tif" || ext == ".tiff";
+}
+
+// Directories expand to their image files (sorted, not recursive); anything else (files, procedural: textures) is taken as is
+void addPath(const std::string& arg, std::vector<std::string>& paths) {
+    std::error_code ec;
+    if (!fs::is_directory(arg, ec)) { paths.push_back(arg); return; }
+    std::vector<std::string> found;
+    for (const auto& e : fs::directory_iterator(arg, ec))
+        if (e.is_regular_file(ec) && isImageFile(e.path())) found.push_back(e.path().string());
+    std::sort(found.begin(), found.end());
+    paths.insert(paths.end(), found.begin(), found.end());
+}
+
+
+void usage(const char* argv0) {
+    std::cerr << "Usage: " << argv0 << " --input FILE|DIR [--input ...] --texture FILE|DIR|procedural:... [--texture ...] --output DIR\n"
+              << "           [--variants K] [--seed N] [--fixed --mode NAME --opacity 0-100]\n"
+              << "           [--luminance] [--swap-rb] [--manifest FILE] [--jobs N]\n"
+              << "           modes: multiply screen lighten overlay soft-light hard-light color-dodge color-burn\n"
+              << "                  darken difference add\n"
+              << "       " << argv0 << " --replay MANIFEST [--only OUTPUT ...] [--jobs N]\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::vector<std::string> inputs, textures, only;
+    std::string manifestPath, replayPath;
+    DevelopBatchOptions options;
+    int jobs = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        try {
+            if (arg == "--input" && hasValue) addPath(argv[++i], inputs);
+            else if (arg == "--texture" && hasValue) addPath(argv[++i], textures);
+            else if (arg == "--output" && hasValue) options.outDir = argv[++i];
+            else if (arg == "--variants" && hasValue) options.variants = std::max(1, std::stoi(argv[++i]));
+            else if (arg == "--seed" && hasValue) options.seed = std::stoull(argv[++i]);
+            else if (arg == "--fixed") options.randomize = false;
+            else if (arg == "--mode" && hasValue) {
+                options.settings.blendMode = util::blendModeFromName(argv[++i]);
+                if (options.settings.blendMode < 0) { std::cerr << "Bad --mode: " << argv[i] << "\n"; return 1; }
+            }
+            else if (arg == "--opacity" && hasValue) options.settings.opacity = std::clamp(std::stof(argv[++i]), 0.0f, 100.0f) / 100.0f;
+            else if (arg == "--luminance") options.settings.useTextureLuminance = true;
+            else if (arg == "--swap-rb") options.settings.swapRB = true;
+            else if (arg == "--manifest" && hasValue) manifestPath = argv[++i];
+            else if (arg == "--replay" && hasValue) replayPath = argv[++i];
+            else if (arg == "--only" && hasValue) only.push_back(argv[++i]);
+            else if (arg == "--jobs" && hasValue) jobs = std::stoi(argv[++i]);
+            else { std::cerr << "Unknown argument: " << arg << "\n"; usage(argv[0]); return 1; }
+        } catch (const std::exception&) {
+            std::cerr << "Bad value for " << arg << "\n";
+            return 1;
+        }
+    }
+    if (jobs > 0) cv::setNumThreads(jobs);
+
+    std::vector<DevelopManifestRow> rows;
+    if (!replayPath.empty()) {
+        if (!readDevelopManifest(replayPath, rows)) { std::cerr << "Error: Could not read manifest " << replayPath << "\n"; return 1; }
+        if (!only.empty()) {
+            // Match either the recorded output path or just its file name
+            rows.erase(std::remove_if(rows.begin(), rows.end(), [&](const DevelopManifestRow& r) {
+                const std::string name = fs::path(r.output).filename().string();
+                return std::none_of(only.begin(), only.end(), [&](const std::string& o) { return o == r.output || o == name; });
+            }), rows.end());
+        }
+        if (rows.empty()) { std::cerr << "Error: Nothing to replay\n"; return 1; }
+    } else {
+        if (inputs.empty() || textures.empty() || options.outDir.empty()) { usage(argv[0]); return 1; }
+        rows = planDevelopBatch(inputs, textures, options);
+    }
+
+    std::error_code ec;
+    for (const auto& r : rows) fs::create_directories(fs::path(r.output).parent_path(), ec);
+
+    const int written = runDevelopRows(rows);
+    if (replayPath.empty()) {
+        if (manifestPath.empty()) manifestPath = (fs::path(options.outDir) / "develop_manifest.tsv").string();
+        if (!writeDevelopManifest(manifestPath, rows)) { std::cerr << "Error: Could not write " << manifestPath << "\n"; return 1; }
+    }
+
+    std::cout << "Developed " << written << "/" << rows.size() << "\n";
+    return written == static_cast<int>(rows.size()) ? 0 : 1;
+}
@@ -0,0 +1,356 @@
+// Python extension module `image_extender`: the shared mask and extend kernels on NumPy arrays
+// Build via CMake target: image_extender (configure with -DBUILD_PYTHON_MODULE=ON)
+// Arrays cross without copies: inputs are read through the buffer protocol, results are cv::Mat
+// buffers that numpy.asarray() wraps in place. The GIL is released while a kernel runs.
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <opencv2/opencv.hpp>
+#include <cstring>
+#include <exception>
+#include <string>
+
+#include "vehicle_mask.hpp"
+#include "extend_canvas.hpp"
+
+namespace {
+
+// ---- results: cv::Mat exposed through the buffer protocol ----------------------------------------
+
+struct MatBufferObject
+{
+    PyObject_HEAD
+    cv::Mat* mat;
+    Py_ssize_t shape[3];
+    Py_ssize_t strides[3];
+};
+
+const char* formatOf(int depth)
+{
+    switch (depth)
+    {
+    case CV_8U: return "B";
+    case CV_8S: return "b";
+    case CV_16U: return "H";
+    case CV_16S: return "h";
+    case CV_32S: return "i";
+    case CV_32F: return "f";
+    case CV_64F: return "d";
+    default: return nullptr;
+    }
+}
+
+int depthOf(const char* format, Py_ssize_t itemsize)
+{
+    if (!format) return itemsize == 1 ? CV_8U : -1;
+    if (*format == '@' || *format == '=' || *format == '<') ++format; // native order on little-endian hosts
+    if (std::strlen(format) != 1) return -1;
+    switch (*format)
+    {
+    case 'B': return CV_8U;
+    case 'b': return CV_8S;
+    case 'H': return CV_16U;
+    case 'h': return CV_16S;
+    case 'i': return itemsize == 4 ? CV_32S : -1;
+    case 'f': return CV_32F;
+    case 'd': return CV_64F;
+    default: return -1;
+    }
+}
+
+int MatBuffer_getbuffer(PyObject* self, Py_buffer* view, int flags)
+{
+    auto* o = reinterpret_cast<MatBufferObject*>(self);
+    const cv::Mat& m = *o->mat;
+    view->obj = self;
+    Py_INCREF(self);
+    view->buf = m.data;
+    view->len = static_cast<Py_ssize_t>(m.total() * m.elemSize());
+    view->readonly = 0;
+    view->itemsize = static_cast<Py_ssize_t>(m.elemSize1());
+    view->format = (flags & PyBUF_FORMAT) ? const_cast<char*>(formatOf(m.depth())) : nullptr;
+    view->ndim = m.channels() > 1 ? 3 : 2;
+    view->shape = (flags & PyBUF_ND) ? o->shape : nullptr;
+    view->strides = (flags & PyBUF_STRIDES) ? o->strides : nullptr; // results are continuous
+    view->suboffsets = nullptr;
+    view->internal = nullptr;
+    return 0;
+}
+
+void MatBuffer_dealloc(PyObject* self)
+{
+    delete reinterpret_cast<MatBufferObject*>(self)->mat;
+    Py_TYPE(self)->tp_free(self);
+}
+
+PyBufferProcs MatBufferProcs = { MatBuffer_getbuffer, nullptr };
+PyTypeObject MatBufferType = { PyVarObject_HEAD_INIT(nullptr, 0) };
+
+// numpy.asarray over the Mat's own buffer; the array keeps the Mat alive through its base object.
+// A result that still points into the caller's (borrowed) `input` buffer is copied first.
+PyObject* toArray(cv::Mat m, const Py_buffer& input)
+{
+    const unsigned char* lo = static_cast<const unsigned char*>(input.buf);
+    const bool borrowed = m.data >= lo && m.data < lo + input.strides[0] * input.shape[0];
+    if (borrowed || !m.isContinuous()) m = m.clone();
+    if (!formatOf(m.depth())) { PyErr_SetString(PyExc_TypeError, "unsupported result depth"); return nullptr; }
+
+    static PyObject* asarray = nullptr;
+    if (!asarray)
+    {
+        PyObject* np = PyImport_ImportModule("numpy");
+        if (!np) return nullptr;
+        asarray = PyObject_GetAttrString(np, "asarray");
+        Py_DECREF(np);
+        if (!asarray) return nullptr;
+    }
+
+    auto* o = PyObject_New(MatBufferObject, &MatBufferType);
+    if (!o) return nullptr;
+    o->mat = new cv::Mat(m);
+    o->shape[0] = m.rows; o->shape[1] = m.cols; o->shape[2] = m.channels();
+    o->strides[0] = static_cast<Py_ssize_t>(m.step[0]);
+    o->strides[1] = static_cast<Py_ssize_t>(m.elemSize());
+    o->strides[2] = static_cast<Py_ssize_t>(m.elemSize1());
+    PyObject* arr = PyObject_CallFunctionObjArgs(asarray, reinterpret_cast<PyObject*>(o), nullptr);
+    Py_DECREF(o);
+    return arr;
+}
+
+// ---- inputs: any buffer-protocol object (NumPy array, memoryview, ...) viewed as a cv::Mat --------
+
+struct ArrayView
+{
+    Py_buffer view {};
+    bool held {false};
+    cv::Mat mat;
+
+    ~ArrayView() { if (held) PyBuffer_Release(&view); }
+
+    // `channels` 0 accepts 1..4; rows may be padded but pixels must be packed
+    bool acquire(PyObject* obj, int channels, const char* name)
+    {
+        if (PyObject_GetBuffer(obj, &view, PyBUF_STRIDES | PyBUF_FORMAT) != 0) return false;
+        held = true;
+        const int ch = view.ndim == 3 ? static_cast<int>(view.shape[2]) : 1;
+        const int depth = depthOf(view.format, view.itemsize);
+        const bool shapeOk = (view.ndim == 2 || view.ndim == 3) && ch >= 1 && ch <= 4 && (channels == 0 || ch == channels);
+        if (!shapeOk || depth < 0)
+        {
+            PyErr_Format(PyExc_ValueError, "%s: expected a %s array", name,
+                         channels == 3 ? "HxWx3 uint8" : "2-D (HxW) numeric");
+            return false;
+        }
+        const bool packed = view.strides[1] == view.itemsize * ch && (view.ndim == 2 || view.strides[2] == view.itemsize) &&
+                            view.strides[0] >= view.strides[1] * view.shape[1];
+        if (!packed)
+        {
+            PyErr_Format(PyExc_ValueError, "%s: pixels must be contiguous within rows (use numpy.ascontiguousarray)", name);
+            return false;
+        }
+        mat = cv::Mat(static_cast<int>(view.shape[0]), static_cast<int>(view.shape[1]), CV_MAKETYPE(depth, ch),
+                      view.buf, static_cast<size_t>(view.strides[0]));
+        return true;
+    }
+};
+
+// Runs a kernel without the GIL; C++ exceptions become RuntimeError
+template <class F>
+bool runUnlocked(F&& kernel, bool& result)
+{
+    std::string error;
+    Py_BEGIN_ALLOW_THREADS
+    try { result = kernel(); }
+    catch (const std::exception& e) { error = e.what(); }
+    Py_END_ALLOW_THREADS
+    if (error.empty()) return true;
+    PyErr_SetString(PyExc_RuntimeError, error.c_str());
+    return false;
+}
+
+// ---- keyword arguments -> settings structs ----------------------------------------------------
+
+// Names follow scripts/sam2_vehicle_mask.py
+struct MaskIntField { const char* name; int MaskSettings::* member; };
+struct MaskBoolField { const char* name; bool MaskSettings::* member; };
+const MaskIntField kMaskInts[] = {
+    { "canny_low", &MaskSettings::cannyLow },      { "canny_high", &MaskSettings::cannyHigh },
+    { "kernel", &MaskSettings::morphKernel },      { "dilate", &MaskSettings::dilateIters },
+    { "erode", &MaskSettings::erodeIters },        { "white_thr", &MaskSettings::whiteThreshold },
+    { "min_area", &MaskSettings::minArea },        { "feather", &MaskSettings::featherRadius },
+    { "working_size", &MaskSettings::workingSize },
+};
+const MaskBoolField kMaskBools[] = {
+    { "fast_morph", &MaskSettings::fastMorphology }, { "white_cyc", &MaskSettings::useWhiteCycAssist },
+    { "invert", &MaskSettings::invert },             { "restrict_to_foreground", &MaskSettings::restrictToForeground },
+};
+
+struct ImageIntField { const char* name; int ImageSettings::* member; };
+struct ImageBoolField { const char* name; bool ImageSettings::* member; };
+const ImageIntField kImageInts[] = {
+    { "width", &ImageSettings::width },                { "height", &ImageSettings::height },
+    { "white_threshold", &ImageSettings::whiteThreshold }, { "final_width", &ImageSettings::finalWidth },
+    { "final_height", &ImageSettings::finalHeight },   { "blur", &ImageSettings::blurRadius },
+};
+const ImageBoolField kImageBools[] = {
+    { "stretch", &ImageSettings::stretchIfNeeded },    { "procedural", &ImageSettings::proceduralBackground },
+    { "grain", &ImageSettings::backgroundGrain },      { "horizontal", &ImageSettings::extendHorizontal },
+};
+
+// Applies every keyword to `mask` / `image`; `extraName` (if any) goes to `extra`. Unknown keys raise TypeError.
+bool applyKeywords(PyObject* kwargs, MaskSettings* mask, ImageSettings* image,
+                   const char* extraName = nullptr, double* extra = nullptr)
+{
+    if (!kwargs) return true;
+    PyObject *key, *value;
+    Py_ssize_t pos = 0;
+    while (PyDict_Next(kwargs, &pos, &key, &value))
+    {
+        const char* k = PyUnicode_AsUTF8(key);
+        if (!k) return false;
+        bool known = false;
+        auto asInt = [&](int& dst) { long v = PyLong_AsLong(value); if (v == -1 && PyErr_Occurred()) return false; dst = static_cast<int>(v); return true; };
+        auto asBool = [&](bool& dst) { int v = PyObject_IsTrue(value); if (v < 0) return false; dst = v != 0; return true; };
+        if (mask)
+        {
+            for (const auto& f : kMaskInts) if (!known && std::strcmp(k, f.name) == 0) { known = true; if (!asInt(mask->*f.member)) return false; }
+            for (const auto& f : kMaskBools) if (!known && std::strcmp(k, f.name) == 0) { known = true; if (!asBool(mask->*f.member)) return false; }
+        }
+        if (image)
+        {
+            for (const auto& f : kImageInts) if (!known && std::strcmp(k, f.name) == 0) { known = true; if (!asInt(image->*f.member)) return false; }
+            for (const auto& f : kImageBools) if (!known && std::strcmp(k, f.name) == 0) { known = true; if (!asBool(image->*f.member)) return false; }
+            if (!known && std::strcmp(k, "padding") == 0)
+            {
+                known = true;
+                image->padding = PyFloat_AsDouble(value);
+                if (PyErr_Occurred()) return false;
+            }
+        }
+        if (!known && extraName && std::strcmp(k, extraName) == 0)
+        {
+            known = true;
+            *extra = PyFloat_AsDouble(value);
+            if (PyErr_Occurred()) return false;
+        }
+        if (!known) { PyErr_Format(PyExc_TypeError, "unexpected keyword argument '%s'", k); return false; }
+    }
+    return true;
+}
+
+// Single positional array + keywords
+PyObject* singleArray(PyObject* args, const char* fn)
+{
+    PyObject* arr = nullptr;
+    if (!PyArg_ParseTuple(args, "O", &arr))
+    {
+        PyErr_Format(PyExc_TypeError, "%s() takes one array argument", fn);
+        return nullptr;
+    }
+    return arr;
+}
+
+// ---- functions --------------------------------------------------------------------------------
+
+PyObject* py_compute_vehicle_mask(PyObject*, PyObject* args, PyObject* kwargs)
+{
+    PyObject* obj = singleArray(args, "compute_vehicle_mask");
+    MaskSettings s;
+    ArrayView img;
+    if (!obj || !applyKeywords(kwargs, &s, nullptr) || !img.acquire(obj, 3, "image")) return nullptr;
+    if (img.mat.depth() != CV_8U) { PyErr_SetString(PyExc_ValueError, "image: expected uint8 BGR"); return nullptr; }
+    cv::Mat out;
+    bool ok = false;
+    if (!runUnlocked([&]{ return computeVehicleMaskMat(img.mat, out, s); }, ok)) return nullptr;
+    if (!ok) { PyErr_SetString(PyExc_RuntimeError, "mask computation failed"); return nullptr; }
+    return toArray(out, img.view);
+}
+
+PyObject* py_postprocess_mask(PyObject*, PyObject* args, PyObject* kwargs)
+{
+    PyObject* obj = singleArray(args, "postprocess_mask");
+    MaskSettings s;
+    double threshold = 0.0;
+    ArrayView scores;
+    if (!obj || !applyKeywords(kwargs, &s, nullptr, "threshold", &threshold) || !scores.acquire(obj, 1, "scores")) return nullptr;
+    cv::Mat out;
+    bool ok = false;
+    if (!runUnlocked([&]{ return postProcessVehicleMask(scores.mat, out, s, threshold); }, ok)) return nullptr;
+    if (!ok) { PyErr_SetString(PyExc_ValueError, "scores: expected a non-empty single-channel array"); return nullptr; }
+    return toArray(out, scores.view);
+}
+
+// Mask stages: CV_8U single-channel in, new CV_8U out
+template <void (*Stage)(const cv::Mat&, cv::Mat&, const MaskSettings&)>
+PyObject* maskStage(PyObject* args, PyObject* kwargs, const char* fn)
+{
+    PyObject* obj = singleArray(args, fn);
+    MaskSettings s;
+    ArrayView mask;
+    if (!obj || !applyKeywords(kwargs, &s, nullptr) || !mask.acquire(obj, 1, "mask")) return nullptr;
+    if (mask.mat.depth() != CV_8U) { PyErr_SetString(PyExc_ValueError, "mask: expected uint8"); return nullptr; }
+    cv::Mat out;
+    bool ok = false;
+    if (!runUnlocked([&]{ Stage(mask.mat, out, s); return true; }, ok)) return nullptr;
+    return toArray(out, mask.view);
+}
+
+PyObject* py_mask_morphology(PyObject*, PyObject* args, PyObject* kwargs) { return maskStage<vehicleMaskMorphology>(args, kwargs, "mask_morphology"); }
+PyObject* py_mask_fill(PyObject*, PyObject* args, PyObject* kwargs) { return maskStage<vehicleMaskFill>(args, kwargs, "mask_fill"); }
+PyObject* py_mask_feather(PyObject*, PyObject* args, PyObject* kwargs) { return maskStage<vehicleMaskFeather>(args, kwargs, "mask_feather"); }
+
+PyObject* py_extend_canvas(PyObject*, PyObject* args, PyObject* kwargs)
+{
+    PyObject* obj = singleArray(args, "extend_canvas");
+    ImageSettings s;
+    ArrayView img;
+    if (!obj || !applyKeywords(kwargs, nullptr, &s) || !img.acquire(obj, 3, "image")) return nullptr;
+    if (img.mat.depth() != CV_8U) { PyErr_SetString(PyExc_ValueError, "image: expected uint8 BGR"); return nullptr; }
+    cv::Mat out;
+    bool ok = false;
+    if (!runUnlocked([&]{ return extendCanvasMat(img.mat, out, s); }, ok)) return nullptr;
+    if (!ok) Py_RETURN_NONE; // no foreground
+    return toArray(out, img.view);
+}
+
+PyMethodDef kMethods[] = {
+    { "compute_vehicle_mask", reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)(void)>(py_compute_vehicle_mask)), METH_VARARGS | METH_KEYWORDS,
+      "compute_vehicle_mask(image, **mask_settings) -> HxW uint8\n"
+      "computeVehicleMaskMat on an HxWx3 uint8 BGR array." },
+    { "postprocess_mask", reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)(void)>(py_postprocess_mask)), METH_VARARGS | METH_KEYWORDS,
+      "postprocess_mask(scores, threshold=0.0, **mask_settings) -> HxW uint8\n"
+      "Model scores/logits > threshold, then component filter, hole fill, feather and invert." },
+    { "mask_morphology", reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)(void)>(py_mask_morphology)), METH_VARARGS | METH_KEYWORDS,
+      "mask_morphology(mask, **mask_settings) -> HxW uint8 (kernel, dilate, erode, fast_morph)" },
+    { "mask_fill", reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)(void)>(py_mask_fill)), METH_VARARGS | METH_KEYWORDS,
+      "mask_fill(mask, **mask_settings) -> HxW uint8 (min_area, hole fill)" },
+    { "mask_feather", reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)(void)>(py_mask_feather)), METH_VARARGS | METH_KEYWORDS,
+      "mask_feather(mask, **mask_settings) -> HxW uint8 (feather)" },
+    { "extend_canvas", reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)(void)>(py_extend_canvas)), METH_VARARGS | METH_KEYWORDS,
+      "extend_canvas(image, **image_settings) -> HxWx3 uint8 or None if no foreground\n"
+      "Keywords: width, height, white_threshold, padding, final_width, final_height, blur,\n"
+      "stretch, procedural, grain, horizontal." },
+    { nullptr, nullptr, 0, nullptr }
+};
+
+PyModuleDef kModule = {
+    PyModuleDef_HEAD_INIT, "image_extender",
+    "Shared image_extender kernels on NumPy arrays (zero-copy in and out).\n"
+    "Mask keywords: canny_low, canny_high, kernel, dilate, erode, fast_morph, white_cyc, white_thr,\n"
+    "min_area, feather, invert, working_size, restrict_to_foreground.",
+    -1, kMethods
+};
+
+}
+
+PyMODINIT_FUNC PyInit_image_extender(void)
+{
+    MatBufferType.tp_name = "image_extender.MatBuffer";
+    MatBufferType.tp_doc = "cv::Mat result exposed through the buffer protocol";
+    MatBufferType.tp_basicsize = sizeof(MatBufferObject);
+    MatBufferType.tp_flags = Py_TPFLAGS_DEFAULT;
+    MatBufferType.tp_dealloc = MatBuffer_dealloc;
+    MatBufferType.tp_as_buffer = &MatBufferProcs;
+    if (PyType_Ready(&MatBufferType) < 0) return nullptr;
+    return PyModule_Create(&kModule);
+}
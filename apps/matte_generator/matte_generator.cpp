@@ -1,42 +1,135 @@
+// Letterbox images onto solid-colour canvases.
+// One input/output pair (legacy), or batches: directories, list files and several
+// size/colour/padding targets per input, decoded once and processed on a thread pool.
+
 #include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
 #include <string>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct MatteTarget {
+    std::string name;           // output suffix in batch mode: <stem>_<name>.<ext> (unnamed: _matte)
+    int width {1920};
+    int height {1080};
+    cv::Scalar color {0, 0, 0}; // BGR
+    float paddingPercent {0};
+};
+
+std::mutex g_logMutex;
 
-cv::Scalar hexToScalar(const std::string& hex) {
+bool hexToScalar(const std::string& hex, cv::Scalar& out) {
+    const std::string digits = (!hex.empty() && hex[0] == '#') ? hex.substr(1) : hex;
     unsigned int r, g, b;
-    if (hex[0] == '#') {
-        sscanf(hex.c_str() + 1, "%02x%02x%02x", &r, &g, &b);
-    } else {
-        sscanf(hex.c_str(), "%02x%02x%02x", &r, &g, &b);
+    if (digits.size() != 6 || std::sscanf(digits.c_str(), "%02x%02x%02x", &r, &g, &b) != 3) return false;
+    out = cv::Scalar(b, g, r); // OpenCV uses BGR
+    return true;
+}
+
+std::string trim(const std::string& s) {
+    size_t a = s.find_first_not_of(" \t"), b = s.find_last_not_of(" \t");
+    return a == std::string::npos ? std::string() : s.substr(a, b - a + 1);
+}
+
+// [name=]WxH[:#rrggbb[:padding%]]; colour and padding default to `defaults`
+bool parseTarget(const std::string& entry, const MatteTarget& defaults, MatteTarget& t) {
+    t = defaults;
+    std::string body = trim(entry);
+    const size_t eq = body.find('=');
+    t.name.clear();
+    if (eq != std::string::npos) { t.name = trim(body.substr(0, eq)); body = body.substr(eq + 1); }
+
+    std::vector<std::string> fields;
+    std::stringstream ss(body);
+    for (std::string f; std::getline(ss, f, ':');) fields.push_back(trim(f));
+    if (fields.empty() || fields.size() > 3) return false;
+
+    char x = 0;
+    std::istringstream size(fields[0]);
+    if (!(size >> t.width >> x >> t.height) || (x != 'x' && x != 'X') || t.width <= 0 || t.height <= 0) return false;
+    if (fields.size() > 1 && !fields[1].empty() && !hexToScalar(fields[1], t.color)) return false;
+    if (fields.size() > 2 && !fields[2].empty()) {
+        try { t.paddingPercent = std::stof(fields[2]); } catch (...) { return false; }
     }
-    return cv::Scalar(b, g, r); // OpenCV uses BGR
+    if (t.name.empty()) t.name = std::to_string(t.width) + "x" + std::to_string(t.height);
+    return true;
 }
 
-int main(int argc, char** argv) {
-    std::string inputPath, outputPath, hexColor = "#000000";
-    int canvasWidth = 1920, canvasHeight = 1080;
-    float paddingPercent = 0;
+bool isImageFile(const fs::path& p) {
+    std::string ext = p.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return char(std::tolower(c)); });
+    return ext == ".jpg" || ext == ".jpeg" || ext == ".png" || ext == ".webp" || ext == ".bmp" ||
+           ext == ".tif" || ext == ".tiff";
+}
 
-    for (int i = 1; i < argc; ++i) {
-        std::string arg = argv[i];
-        if (arg == "--input") inputPath = argv[++i];
-        else if (arg == "--output") outputPath = argv[++i];
-        else if (arg == "--width") canvasWidth = std::stoi(argv[++i]);
-        else if (arg == "--height") canvasHeight = std::stoi(argv[++i]);
-        else if (arg == "--padding") paddingPercent = std::stof(argv[++i]);
-        else if (arg == "--color") hexColor = argv[++i];
+// Directories expand to their image files (sorted, not recursive); anything else is taken as a path
+void addInput(const std::string& arg, std::vector<std::string>& inputs) {
+    std::error_code ec;
+    if (!fs::is_directory(arg, ec)) { inputs.push_back(arg); return; }
+    std::vector<std::string> found;
+    for (const auto& e : fs::directory_iterator(arg, ec))
+        if (e.is_regular_file(ec) && isImageFile(e.path())) found.push_back(e.path().string());
+    std::sort(found.begin(), found.end());
+    inputs.insert(inputs.end(), found.begin(), found.end());
+}
+
+// One path per line; blank lines and lines starting with '#' are skipped. "-" reads stdin.
+bool addList(const std::string& listPath, std::vector<std::string>& inputs) {
+    std::ifstream file;
+    if (listPath != "-") { file.open(listPath); if (!file) return false; }
+    std::istream& in = listPath == "-" ? std::cin : file;
+    for (std::string line; std::getline(in, line);) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        line = trim(line);
+        if (!line.empty() && line[0] != '#') addInput(line, inputs);
     }
+    return true;
+}
+
+// Colour everything outside `content`; the content area is overwritten by the caller
+void fillOutside(cv::Mat& canvas, const cv::Rect& content, const cv::Scalar& color) {
+    const int W = canvas.cols, H = canvas.rows;
+    if (content.y > 0) canvas.rowRange(0, content.y).setTo(color);
+    if (content.br().y < H) canvas.rowRange(content.br().y, H).setTo(color);
+    cv::Mat band = canvas.rowRange(content.y, content.br().y);
+    if (content.x > 0) band.colRange(0, content.x).setTo(color);
+    if (content.br().x < W) band.colRange(content.br().x, W).setTo(color);
+}
 
-    cv::Mat input = cv::imread(inputPath);
-    if (input.empty()) {
-        std::cerr << "Error: Could not read input image.\n";
-        return 1;
+// Canvas buffers of one worker, reused by every file rendered at the same size and type
+class CanvasPool {
+public:
+    cv::Mat& get(int w, int h, int type) {
+        cv::Mat& m = buffers_[std::make_tuple(w, h, type)];
+        m.create(h, w, type); // no-op once allocated
+        return m;
     }
+private:
+    std::map<std::tuple<int, int, int>, cv::Mat> buffers_;
+};
 
-    int padX = static_cast<int>(canvasWidth * paddingPercent / 100.0);
-    int padY = static_cast<int>(canvasHeight * paddingPercent / 100.0);
-    int contentWidth = canvasWidth - 2 * padX;
-    int contentHeight = canvasHeight - 2 * padY;
+void renderMatte(const cv::Mat& input, const MatteTarget& t, CanvasPool& pool, cv::Mat& out) {
+    int padX = static_cast<int>(t.width * t.paddingPercent / 100.0);
+    int padY = static_cast<int>(t.height * t.paddingPercent / 100.0);
+    int contentWidth = std::max(1, t.width - 2 * padX);
+    int contentHeight = std::max(1, t.height - 2 * padY);
 
     // Resize while keeping aspect ratio
     double inputRatio = static_cast<double>(input.cols) / input.rows;
@@ -50,19 +143,196 @@ int main(int argc, char** argv) {
         targetHeight = contentHeight;
         targetWidth = static_cast<int>(contentHeight * inputRatio);
     }
+    targetWidth = std::clamp(targetWidth, 1, t.width);
+    targetHeight = std::clamp(targetHeight, 1, t.height);
+
+    int xOffset = (t.width - targetWidth) / 2;
+    int yOffset = (t.height - targetHeight) / 2;
+    const cv::Rect content(xOffset, yOffset, targetWidth, targetHeight);
+
+    out = pool.get(t.width, t.height, input.type());
+    fillOutside(out, content, t.color);
+    cv::Mat dst = out(content);
+    if (content.size() == input.size()) {
+        input.copyTo(dst);
+    } else if (targetWidth <= input.cols && targetHeight <= input.rows) {
+        // Area averaging for shrinks (bilinear aliases badly on large reductions)
+        cv::Mat resized;
+        cv::resize(input, resized, content.size(), 0, 0, cv::INTER_AREA);
+        resized.copyTo(dst);
+    } else {
+        cv::resize(input, dst, content.size(), 0, 0, cv::INTER_LINEAR);
+    }
+}
 
-    cv::Mat resized;
-    cv::resize(input, resized, cv::Size(targetWidth, targetHeight));
+// Always suffixed, so a batch writing into its input folder never replaces a source
+std::string batchOutputPath(const std::string& outDir, const std::string& stem, const std::string& inPath,
+                            const MatteTarget& t, bool named, const std::string& format) {
+    std::string ext = format.empty() ? fs::path(inPath).extension().string() : "." + format;
+    return (fs::path(outDir) / (stem + "_" + (named ? t.name : "matte") + ext)).string();
+}
 
-    cv::Mat canvas(canvasHeight, canvasWidth, input.type(), hexToScalar(hexColor));
+// Output stem per input; same-named files from different folders become <stem>_2, <stem>_3...
+std::vector<std::string> uniqueStems(const std::vector<std::string>& inputs) {
+    auto lower = [](std::string v) { std::transform(v.begin(), v.end(), v.begin(), [](unsigned char c) { return char(std::tolower(c)); }); return v; };
+    std::set<std::string> used; // lower-cased: case-insensitive file systems collide too
+    std::vector<std::string> stems;
+    for (const auto& in : inputs) {
+        const std::string base = fs::path(in).stem().string();
+        std::string stem = base;
+        for (int dup = 2; used.count(lower(stem)); ++dup) stem = base + "_" + std::to_string(dup);
+        used.insert(lower(stem));
+        stems.push_back(stem);
+    }
+    return stems;
+}
 
-    int xOffset = (canvasWidth - targetWidth) / 2;
-    int yOffset = (canvasHeight - targetHeight) / 2;
+std::string canonicalPath(const std::string& path) {
+    std::error_code ec;
+    const fs::path p = fs::weakly_canonical(path, ec);
+    return ec ? path : p.string();
+}
 
-    resized.copyTo(canvas(cv::Rect(xOffset, yOffset, resized.cols, resized.rows)));
+std::vector<int> writeParams(const std::string& path, int quality) {
+    std::string ext = fs::path(path).extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return char(std::tolower(c)); });
+    if (ext == ".jpg" || ext == ".jpeg") return { cv::IMWRITE_JPEG_QUALITY, quality };
+    if (ext == ".webp") return { cv::IMWRITE_WEBP_QUALITY, quality };
+    return {};
+}
 
-    cv::imwrite(outputPath, canvas);
-    std::cout << "Saved to " << outputPath << "\n";
-    return 0;
+void usage(const char* argv0) {
+    std::cerr << "Usage: " << argv0 << " --input PATH --output FILE [--width W] [--height H] [--padding %] [--color #rrggbb]\n"
+              << "       " << argv0 << " --input FILE|DIR [--input ...] [--list FILE|-] --output DIR\n"
+              << "           [--target [name=]WxH[:#rrggbb[:padding%]] ...] [--targets SPEC,SPEC;...]\n"
+              << "           [--format jpg|png|webp|...] [--quality 1-100] [--jobs N]\n";
 }
 
+} // namespace
+
+int main(int argc, char** argv) {
+    std::vector<std::string> inputs;
+    std::vector<std::string> targetSpecs;
+    std::string outputPath, hexColor = "#000000", format;
+    int quality = 95, jobs = 0;
+    MatteTarget defaults;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        try {
+            if (arg == "--input" && hasValue) addInput(argv[++i], inputs);
+            else if (arg == "--list" && hasValue) {
+                if (!addList(argv[++i], inputs)) { std::cerr << "Error: Could not read list " << argv[i] << "\n"; return 1; }
+            }
+            else if (arg == "--output" && hasValue) outputPath = argv[++i];
+            else if (arg == "--width" && hasValue) defaults.width = std::stoi(argv[++i]);
+            else if (arg == "--height" && hasValue) defaults.height = std::stoi(argv[++i]);
+            else if (arg == "--padding" && hasValue) defaults.paddingPercent = std::stof(argv[++i]);
+            else if (arg == "--color" && hasValue) hexColor = argv[++i];
+            else if ((arg == "--target" || arg == "--targets") && hasValue) {
+                std::string spec = argv[++i];
+                std::replace(spec.begin(), spec.end(), ';', ',');
+                std::stringstream ss(spec);
+                for (std::string e; std::getline(ss, e, ',');) if (!trim(e).empty()) targetSpecs.push_back(e);
+            }
+            else if (arg == "--format" && hasValue) { format = argv[++i]; if (!format.empty() && format[0] == '.') format.erase(0, 1); }
+            else if (arg == "--quality" && hasValue) quality = std::clamp(std::stoi(argv[++i]), 1, 100);
+            else if (arg == "--jobs" && hasValue) jobs = std::stoi(argv[++i]);
+            else { std::cerr << "Unknown argument: " << arg << "\n"; usage(argv[0]); return 1; }
+        } catch (const std::exception&) {
+            std::cerr << "Bad value for " << arg << "\n";
+            return 1;
+        }
+    }
+    if (!hexToScalar(hexColor, defaults.color)) { std::cerr << "Bad --color: " << hexColor << "\n"; return 1; }
+    if (defaults.width <= 0 || defaults.height <= 0) { std::cerr << "Canvas size must be positive\n"; return 1; }
+
+    std::vector<MatteTarget> targets;
+    std::set<std::string> targetNames; // lower-cased, as the names end up in file names
+    for (const auto& spec : targetSpecs) {
+        MatteTarget t;
+        if (!parseTarget(spec, defaults, t)) { std::cerr << "Bad --target: " << spec << "\n"; return 1; }
+        std::string key = t.name;
+        std::transform(key.begin(), key.end(), key.begin(), [](unsigned char c) { return char(std::tolower(c)); });
+        if (!targetNames.insert(key).second) {
+            std::cerr << "Duplicate target name '" << t.name << "' (name targets that share a size: name=WxH...)\n";
+            return 1;
+        }
+        targets.push_back(t);
+    }
+    const bool named = !targets.empty();
+    if (targets.empty()) targets.push_back(defaults);
+
+    if (inputs.empty() || outputPath.empty()) { usage(argv[0]); return 1; }
+
+    // Legacy form: one input, one target, --output names the file
+    std::error_code ec;
+    const bool batch = inputs.size() > 1 || targets.size() > 1 || fs::is_directory(outputPath, ec);
+    if (!batch) {
+        cv::Mat input = cv::imread(inputs[0]);
+        if (input.empty()) {
+            std::cerr << "Error: Could not read input image.\n";
+            return 1;
+        }
+        if (canonicalPath(outputPath) == canonicalPath(inputs[0])) { std::cerr << "Error: Output would overwrite the input " << inputs[0] << "\n"; return 1; }
+        CanvasPool pool;
+        cv::Mat canvas;
+        renderMatte(input, targets[0], pool, canvas);
+        if (!cv::imwrite(outputPath, canvas, writeParams(outputPath, quality))) { std::cerr << "Error: Could not write " << outputPath << "\n"; return 1; }
+        std::cout << "Saved to " << outputPath << "\n";
+        return 0;
+    }
+
+    fs::create_directories(outputPath, ec);
+    if (!fs::is_directory(outputPath, ec)) { std::cerr << "Error: Cannot create output directory " << outputPath << "\n"; return 1; }
+
+    // Whole files per thread; the per-image kernels then run single-threaded so workers don't oversubscribe
+    const size_t workers = std::min(inputs.size(), static_cast<size_t>(jobs > 0 ? jobs : std::max(1u, std::thread::hardware_concurrency())));
+    if (workers > 1) cv::setNumThreads(1);
+
+    const std::vector<std::string> stems = uniqueStems(inputs);
+    std::set<std::string> sources; // never written to, whichever input's output lands on them
+    for (const auto& in : inputs) sources.insert(canonicalPath(in));
+    std::atomic<size_t> next {0};
+    std::atomic<int> written {0}, failed {0};
+    auto body = [&]() {
+        CanvasPool pool;
+        cv::Mat canvas;
+        for (;;) {
+            const size_t idx = next++;
+            if (idx >= inputs.size()) return;
+            const std::string& in = inputs[idx];
+            cv::Mat input = cv::imread(in);
+            if (input.empty()) {
+                std::lock_guard<std::mutex> lock(g_logMutex);
+                std::cerr << "Error: Could not read " << in << "\n";
+                failed += static_cast<int>(targets.size());
+                continue;
+            }
+            for (const auto& t : targets) {
+                renderMatte(input, t, pool, canvas);
+                const std::string out = batchOutputPath(outputPath, stems[idx], in, t, named, format);
+                if (sources.count(canonicalPath(out))) {
+                    ++failed;
+                    std::lock_guard<std::mutex> lock(g_logMutex);
+                    std::cerr << "Error: " << out << " would overwrite an input\n";
+                    continue;
+                }
+                bool ok = false;
+                try { ok = cv::imwrite(out, canvas, writeParams(out, quality)); } catch (const cv::Exception&) {}
+                if (ok) { ++written; continue; }
+                ++failed;
+                std::lock_guard<std::mutex> lock(g_logMutex);
+                std::cerr << "Error: Could not write " << out << "\n";
+            }
+        }
+    };
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < workers; ++t) threads.emplace_back(body);
+    body();
+    for (auto& t : threads) t.join();
+
+    std::cout << "Saved " << written << "/" << inputs.size() * targets.size() << " to " << outputPath << "\n";
+    return failed == 0 ? 0 : 1;
+}
@@ -4,6 +4,9 @@
 #include <wx/sizer.h>
 #include <wx/statline.h>
 #include <wx/filename.h>
+#include <cmath>
+#include "film_develop.hpp"
+#include "film_grain.hpp"
 
 // Define custom events
 wxDEFINE_EVENT(wxEVT_WXUI_SETTINGS_CHANGED, wxCommandEvent);
@@ -139,6 +142,37 @@ void WxControlPanel::BuildUI()
     blurRadius_ = new wxSpinCtrl(this, wxID_ANY, wxEmptyString, wxDefaultPosition, wxSize(80, -1), wxSP_ARROW_KEYS, 0, 50, 0);
     paramsRow->Add(blurRadius_, 0, wxRIGHT, 12);
     paramsBox->Add(paramsRow, 0, wxALL, 6);
+    // Background synthesis for extension strips (Extend Canvas)
+    auto* bgRow = new wxBoxSizer(wxHORIZONTAL);
+    proceduralBg_ = new wxCheckBox(this, wxID_ANY, "Procedural background");
+    proceduralBg_->SetValue(false);
+    bgGrain_ = new wxCheckBox(this, wxID_ANY, "Grain");
+    bgGrain_->SetValue(true);
+    bgRow->Add(proceduralBg_, 0, wxRIGHT, 12);
+    bgRow->Add(bgGrain_, 0, wxRIGHT, 12);
+    extendWidth_ = new wxCheckBox(this, wxID_ANY, "Extend width (2-D)");
+    extendWidth_->SetValue(false);
+    bgRow->Add(extendWidth_, 0, wxRIGHT, 12);
+    paramsBox->Add(bgRow, 0, wxLEFT | wxRIGHT | wxBOTTOM, 6);
+    // Rendition set (Extend Canvas batch): preset name or name=WxH list; overrides Width/Height
+    auto* renditionsRow = new wxBoxSizer(wxHORIZONTAL);
+    renditionsLabel_ = new wxStaticText(this, wxID_ANY, "Renditions:");
+    renditions_ = new wxTextCtrl(this, wxID_ANY);
+    renditions_->SetHint("e.g. ecommerce or hero=1920x1080,thumb=480x270:jpg:85");
+    renditionsRow->Add(renditionsLabel_, 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 4);
+    renditionsRow->Add(renditions_, 1);
+    paramsBox->Add(renditionsRow, 0, wxEXPAND | wxLEFT | wxRIGHT | wxBOTTOM, 6);
+    // Extra batch outputs from the same decode (Extend Canvas / Vehicle Mask / Auto Fit)
+    auto* alsoRow = new wxBoxSizer(wxHORIZONTAL);
+    alsoWriteLabel_ = new wxStaticText(this, wxID_ANY, "Also write:");
+    alsoExtend_ = new wxCheckBox(this, wxID_ANY, "Extended");
+    alsoMask_ = new wxCheckBox(this, wxID_ANY, "Mask");
+    alsoAutoFit_ = new wxCheckBox(this, wxID_ANY, "Auto Fit");
+    alsoRow->Add(alsoWriteLabel_, 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 4);
+    alsoRow->Add(alsoExtend_, 0, wxRIGHT, 12);
+    alsoRow->Add(alsoMask_, 0, wxRIGHT, 12);
+    alsoRow->Add(alsoAutoFit_, 0, wxRIGHT, 12);
+    paramsBox->Add(alsoRow, 0, wxLEFT | wxRIGHT | wxBOTTOM, 6);
 
     // Crop settings: aspect is implicitly derived from canvas Width/Height
 
@@ -168,6 +202,9 @@ void WxControlPanel::BuildUI()
     maskRow1->Add(new wxStaticText(this, wxID_ANY, "Kernel:"), 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 4);
     morphKernel_ = new wxSpinCtrl(this, wxID_ANY, wxEmptyString, wxDefaultPosition, wxSize(70,-1), wxSP_ARROW_KEYS, 1, 99, 7);
     maskRow1->Add(morphKernel_, 0, wxRIGHT, 10);
+    maskRow1->Add(new wxStaticText(this, wxID_ANY, "Work px:"), 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 4);
+    maskWorkSize_ = new wxSpinCtrl(this, wxID_ANY, wxEmptyString, wxDefaultPosition, wxSize(80,-1), wxSP_ARROW_KEYS, 0, 8000, 0);
+    maskRow1->Add(maskWorkSize_, 0, wxRIGHT, 10);
     maskBox_->Add(maskRow1, 0, wxALL, 6);
 
     auto* maskRow2 = new wxBoxSizer(wxHORIZONTAL);
@@ -177,6 +214,9 @@ void WxControlPanel::BuildUI()
     maskRow2->Add(new wxStaticText(this, wxID_ANY, "Erode:"), 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 4);
     erodeIters_ = new wxSpinCtrl(this, wxID_ANY, wxEmptyString, wxDefaultPosition, wxSize(70,-1), wxSP_ARROW_KEYS, 0, 50, 0);
     maskRow2->Add(erodeIters_, 0, wxRIGHT, 10);
+    fastMorph_ = new wxCheckBox(this, wxID_ANY, "Fast morph");
+    fastMorph_->SetValue(false);
+    maskRow2->Add(fastMorph_, 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 10);
     maskRow2->Add(new wxStaticText(this, wxID_ANY, "Min area:"), 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 4);
     minArea_ = new wxSpinCtrl(this, wxID_ANY, wxEmptyString, wxDefaultPosition, wxSize(90,-1), wxSP_ARROW_KEYS, 0, 20000000, 5000);
     maskRow2->Add(minArea_, 0, wxRIGHT, 10);
@@ -195,8 +235,24 @@ void WxControlPanel::BuildUI()
     invertMask_ = new wxCheckBox(this, wxID_ANY, "Invert output");
     invertMask_->SetValue(false);
     maskRow3->Add(invertMask_, 0, wxRIGHT, 10);
+    maskRoi_ = new wxCheckBox(this, wxID_ANY, "Foreground ROI");
+    maskRoi_->SetValue(false);
+    maskRow3->Add(maskRoi_, 0, wxRIGHT, 10);
     maskBox_->Add(maskRow3, 0, wxALL, 6);
 
+    auto* maskRow4 = new wxBoxSizer(wxHORIZONTAL);
+    maskRow4->Add(new wxStaticText(this, wxID_ANY, "Mask file:"), 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 4);
+    maskFormat_ = new wxComboBox(this, wxID_ANY);
+    // Order matches MaskFormat
+    maskFormat_->Append("8-bit PNG");
+    maskFormat_->Append("1-bit PNG");
+    maskFormat_->Append("RLE sidecar (.rle)");
+    maskFormat_->Append("Cutout PNG (mask as alpha)");
+    maskFormat_->Append("Cutout WebP (mask as alpha)");
+    maskFormat_->SetSelection(0);
+    maskRow4->Add(maskFormat_, 0, wxRIGHT, 10);
+    maskBox_->Add(maskRow4, 0, wxALL, 6);
+
     root->Add(maskBox_, 0, wxEXPAND | wxLEFT | wxRIGHT, 6);
 
     // Section: Output folder
@@ -284,6 +340,9 @@ void WxControlPanel::WireEvents()
     padding_->Bind(wxEVT_SPINCTRLDOUBLE, fireSettingsChanged);
     blurRadius_->Bind(wxEVT_SPINCTRL, fireSettingsChanged);
     if (stretchIfNeeded_) stretchIfNeeded_->Bind(wxEVT_CHECKBOX, fireSettingsChanged);
+    if (proceduralBg_) proceduralBg_->Bind(wxEVT_CHECKBOX, fireSettingsChanged);
+    if (bgGrain_) bgGrain_->Bind(wxEVT_CHECKBOX, fireSettingsChanged);
+    if (extendWidth_) extendWidth_->Bind(wxEVT_CHECKBOX, fireSettingsChanged);
     if (splits_) { splits_->Bind(wxEVT_SPINCTRL, fireSettingsChanged); splits_->Bind(wxEVT_TEXT, fireSettingsChanged); }
     // Also react to direct text edits in spin controls
     width_->Bind(wxEVT_TEXT, fireSettingsChanged);
@@ -297,6 +356,9 @@ void WxControlPanel::WireEvents()
     morphKernel_->Bind(wxEVT_SPINCTRL, fireMaskChanged);
     dilateIters_->Bind(wxEVT_SPINCTRL, fireMaskChanged);
     erodeIters_->Bind(wxEVT_SPINCTRL, fireMaskChanged);
+    fastMorph_->Bind(wxEVT_CHECKBOX, fireMaskChanged);
+    maskWorkSize_->Bind(wxEVT_SPINCTRL, fireMaskChanged);
+    maskWorkSize_->Bind(wxEVT_TEXT, fireMaskChanged);
     // text edit bindings for responsive preview
     cannyLow_->Bind(wxEVT_TEXT, fireMaskChanged);
     cannyHigh_->Bind(wxEVT_TEXT, fireMaskChanged);
@@ -311,6 +373,7 @@ void WxControlPanel::WireEvents()
     minArea_->Bind(wxEVT_TEXT, fireMaskChanged);
     featherRadiusMask_->Bind(wxEVT_TEXT, fireMaskChanged);
     invertMask_->Bind(wxEVT_CHECKBOX, fireMaskChanged);
+    maskRoi_->Bind(wxEVT_CHECKBOX, fireMaskChanged);
     modeBox_->Bind(wxEVT_COMBOBOX, [this](wxCommandEvent&){
         EnsureDefaultOutputFolder();
         const bool showMask = (getMode() == ProcessingMode::VehicleMask);
@@ -322,6 +385,16 @@ void WxControlPanel::WireEvents()
         const bool showWhiteThr = (getMode() == ProcessingMode::ExtendCanvas);
         if (whiteThrLabel_) whiteThrLabel_->Show(showWhiteThr);
         if (whiteThr_) whiteThr_->Show(showWhiteThr);
+        if (proceduralBg_) proceduralBg_->Show(showWhiteThr);
+        if (bgGrain_) bgGrain_->Show(showWhiteThr);
+        if (extendWidth_) extendWidth_->Show(showWhiteThr);
+        if (renditionsLabel_) renditionsLabel_->Show(showWhiteThr);
+        if (renditions_) renditions_->Show(showWhiteThr);
+        const bool showAlso = (showWhiteThr || showMask || isAutoFit);
+        if (alsoWriteLabel_) alsoWriteLabel_->Show(showAlso);
+        if (alsoExtend_) alsoExtend_->Show(showAlso && !showWhiteThr);
+        if (alsoMask_) alsoMask_->Show(showAlso && !showMask);
+        if (alsoAutoFit_) alsoAutoFit_->Show(showAlso && !isAutoFit);
         // Padding applies to Extend Canvas and Auto Fit
         const bool showPadding = (!isCropLike && !isFilm);
         if (paddingLabel_) paddingLabel_->Show(showPadding);
@@ -357,6 +430,17 @@ void WxControlPanel::WireEvents()
     const bool startShowWhiteThr = (getMode() == ProcessingMode::ExtendCanvas);
     if (whiteThrLabel_) whiteThrLabel_->Show(startShowWhiteThr);
     if (whiteThr_) whiteThr_->Show(startShowWhiteThr);
+    if (proceduralBg_) proceduralBg_->Show(startShowWhiteThr);
+    if (bgGrain_) bgGrain_->Show(startShowWhiteThr);
+    if (extendWidth_) extendWidth_->Show(startShowWhiteThr);
+    if (renditionsLabel_) renditionsLabel_->Show(startShowWhiteThr);
+    if (renditions_) renditions_->Show(startShowWhiteThr);
+    const bool startShowMask = (getMode() == ProcessingMode::VehicleMask);
+    const bool startShowAlso = (startShowWhiteThr || startShowMask || startIsAutoFit);
+    if (alsoWriteLabel_) alsoWriteLabel_->Show(startShowAlso);
+    if (alsoExtend_) alsoExtend_->Show(startShowAlso && !startShowWhiteThr);
+    if (alsoMask_) alsoMask_->Show(startShowAlso && !startShowMask);
+    if (alsoAutoFit_) alsoAutoFit_->Show(startShowAlso && !startIsAutoFit);
     const bool startShowPadding = (!startIsCropLike && !startIsFilm);
     if (paddingLabel_) paddingLabel_->Show(startShowPadding);
     if (padding_) padding_->Show(startShowPadding);
@@ -429,8 +513,8 @@ void WxControlPanel::AddTextures(const wxArrayString& paths)
 void WxControlPanel::UpdateProcessEnabled()
 {
     processBtn_->Enable(!batchFiles_.IsEmpty());
-    if (developBtn_) developBtn_->Enable(!batchFiles_.IsEmpty() && !textureFiles_.IsEmpty());
-    if (randomizeBtn_) randomizeBtn_->Enable(!textureFiles_.IsEmpty());
+    if (developBtn_) developBtn_->Enable(!batchFiles_.IsEmpty()); // procedural grain when no textures are loaded
+    if (randomizeBtn_) randomizeBtn_->Enable(true);
 }
 
 void WxControlPanel::EnsureDefaultOutputFolder()
@@ -466,6 +550,9 @@ ImageSettings WxControlPanel::getCurrentSettings() const
     s.finalWidth = -1; // optional; can be added to UI if needed
     s.finalHeight = -1;
     s.stretchIfNeeded = stretchIfNeeded_ ? stretchIfNeeded_->GetValue() : false;
+    s.proceduralBackground = proceduralBg_ ? proceduralBg_->GetValue() : false;
+    s.backgroundGrain = bgGrain_ ? bgGrain_->GetValue() : true;
+    s.extendHorizontal = extendWidth_ ? extendWidth_->GetValue() : false;
     return s;
 }
 
@@ -477,6 +564,9 @@ void WxControlPanel::loadSettings(const ImageSettings& settings)
     padding_->SetValue(settings.padding);
     blurRadius_->SetValue(settings.blurRadius);
     if (stretchIfNeeded_) stretchIfNeeded_->SetValue(settings.stretchIfNeeded);
+    if (proceduralBg_) proceduralBg_->SetValue(settings.proceduralBackground);
+    if (bgGrain_) bgGrain_->SetValue(settings.backgroundGrain);
+    if (extendWidth_) extendWidth_->SetValue(settings.extendHorizontal);
 }
 
 int WxControlPanel::getScaleFactor() const
@@ -510,7 +600,12 @@ wxArrayString WxControlPanel::getTextureFiles() const
 
 wxString WxControlPanel::getSelectedTexturePath() const
 {
-    if (textureFiles_.IsEmpty()) return wxString();
+    if (textureFiles_.IsEmpty())
+    {
+        GrainSettings grain;
+        grain.seed = proceduralSeed_;
+        return wxString::FromUTF8(grainSpec(grain).c_str());
+    }
     int sel = texList_ ? texList_->GetSelection() : wxNOT_FOUND;
     if (sel == wxNOT_FOUND || sel < 0 || sel >= (int)textureFiles_.size()) return textureFiles_[0];
     return textureFiles_[sel];
@@ -539,18 +634,16 @@ bool WxControlPanel::getRandomizeOnDevelop() const
 
 void WxControlPanel::RandomizeDevelopParams()
 {
-    // Pick random texture, mode, opacity and set UI state accordingly
-    if (!textureFiles_.IsEmpty() && texList_) {
-        int count = (int)textureFiles_.size();
-        int idx = rand() % count;
-        texList_->SetSelection(idx);
-    }
-    if (blendBox_) {
-        int idx = rand() % 3; // 0..2
-        blendBox_->SetSelection(idx);
-    }
+    // Same seeded draw as batch develop, so a session's sequence of picks is reproducible
+    const uint64_t seed = developVariantSeed(0, "ui", ++developDraws_);
+    int texture = 0;
+    DevelopSettings picked;
+    pickDevelopVariant(seed, textureFiles_.size(), getDevelopSettings(), texture, picked);
+    proceduralSeed_ = seed;
+    if (!textureFiles_.IsEmpty() && texList_) texList_->SetSelection(texture);
+    if (blendBox_) blendBox_->SetSelection(picked.blendMode);
     if (opacitySlider_) {
-        int val = 30 + (rand() % 51); // 30..80
+        int val = static_cast<int>(std::lround(picked.opacity * 100.0f)); // 30..80
         opacitySlider_->SetValue(val);
         if (opacityLabel_) opacityLabel_->SetLabel(wxString::Format("Opacity: %d%%", val));
     }
@@ -566,6 +659,16 @@ bool WxControlPanel::getSwapRB() const
     return swapRB_ ? swapRB_->GetValue() : false;
 }
 
+DevelopSettings WxControlPanel::getDevelopSettings() const
+{
+    DevelopSettings d;
+    d.blendMode = getDevelopBlendMode();
+    d.opacity = getDevelopOpacity();
+    d.useTextureLuminance = getUseTextureLuminance();
+    d.swapRB = getSwapRB();
+    return d;
+}
+
 ProcessingMode WxControlPanel::getMode() const
 {
     int sel = modeBox_ ? modeBox_->GetSelection() : 0;
@@ -585,14 +688,23 @@ MaskSettings WxControlPanel::getMaskSettings() const
     int k = morphKernel_->GetValue(); if (k % 2 == 0) k += 1; if (k < 1) k = 1; m.morphKernel = k;
     m.dilateIters = dilateIters_->GetValue();
     m.erodeIters = erodeIters_->GetValue();
+    m.fastMorphology = fastMorph_->GetValue();
     m.useWhiteCycAssist = whiteCycAssist_->GetValue();
     m.whiteThreshold = whiteThrMask_->GetValue();
     m.minArea = minArea_->GetValue();
     m.featherRadius = featherRadiusMask_->GetValue();
     m.invert = invertMask_->GetValue();
+    m.workingSize = maskWorkSize_->GetValue();
+    m.restrictToForeground = maskRoi_->GetValue();
     return m;
 }
 
+MaskFormat WxControlPanel::getMaskFormat() const
+{
+    const int sel = maskFormat_ ? maskFormat_->GetSelection() : 0;
+    return sel > 0 ? static_cast<MaskFormat>(sel) : MaskFormat::Png8;
+}
+
 double WxControlPanel::getCropAspectRatio() const
 {
     int w = width_ ? width_->GetValue() : 0;
@@ -615,3 +727,21 @@ int WxControlPanel::getSplitterCount() const
     if (v < 2) v = 2; if (v > 12) v = 12;
     return v;
 }
+
+wxString WxControlPanel::getRenditionSpec() const
+{
+    return renditions_ ? renditions_->GetValue().Trim().Trim(false) : wxString();
+}
+
+std::vector<ProcessingMode> WxControlPanel::getBatchOutputModes() const
+{
+    const ProcessingMode mode = getMode();
+    std::vector<ProcessingMode> modes { mode };
+    if (mode != ProcessingMode::ExtendCanvas && mode != ProcessingMode::VehicleMask && mode != ProcessingMode::AutoFitVehicle)
+        return modes;
+    auto add = [&](wxCheckBox* box, ProcessingMode m){ if (box && box->GetValue() && m != mode) modes.push_back(m); };
+    add(alsoExtend_, ProcessingMode::ExtendCanvas);
+    add(alsoMask_, ProcessingMode::VehicleMask);
+    add(alsoAutoFit_, ProcessingMode::AutoFitVehicle);
+    return modes;
+}
@@ -7,6 +7,7 @@
 #include <wx/gauge.h>
 #include <wx/filepicker.h>
 #include <wx/slider.h>
+#include <cstdint>
 #include <vector>
 #include <map>
 #include <wx/dnd.h>
@@ -14,6 +15,8 @@
 #include "models/ImageSettings.hpp"
 #include "models/ProcessingMode.hpp"
 #include "models/MaskSettings.hpp"
+#include "models/MaskFormat.hpp"
+#include "models/DevelopSettings.hpp"
 
 // Custom event declarations
 wxDECLARE_EVENT(wxEVT_WXUI_SETTINGS_CHANGED, wxCommandEvent);
@@ -35,16 +38,21 @@ public:
     wxString getOutputFolder() const;
     wxArrayString getBatchFiles() const;
     wxArrayString getTextureFiles() const;
-    wxString getSelectedTexturePath() const;
+    wxString getSelectedTexturePath() const; // a procedural grain path when no textures are loaded
     int getDevelopBlendMode() const; // 0=multiply,1=screen,2=lighten
     float getDevelopOpacity() const; // 0..1
     bool getRandomizeOnDevelop() const;
     void RandomizeDevelopParams();
     bool getUseTextureLuminance() const; // if true, convert texture to grayscale
     bool getSwapRB() const; // debug: swap R/B channels in texture
+    DevelopSettings getDevelopSettings() const; // blend mode, opacity and the two texture flags above
     ProcessingMode getMode() const;
     MaskSettings getMaskSettings() const;
+    MaskFormat getMaskFormat() const; // encoding of exported masks
     int getSplitterCount() const;
+    wxString getRenditionSpec() const; // empty = single output per image
+    // Current mode plus any extra outputs ticked under "Also write"; more than one = fan-out batch
+    std::vector<ProcessingMode> getBatchOutputModes() const;
 
 private:
     void BuildUI();
@@ -70,6 +78,8 @@ private:
     wxStaticText* opacityLabel_ {nullptr};
     wxButton* randomizeBtn_ {nullptr};
     wxCheckBox* randomOnDevelop_ {nullptr};
+    int developDraws_ {0};
+    uint64_t proceduralSeed_ {0}; // grain used when no texture files are loaded
     wxCheckBox* useTexLuma_ {nullptr};
     wxCheckBox* swapRB_ {nullptr};
 
@@ -78,6 +88,15 @@ private:
     wxSpinCtrl* whiteThr_ {nullptr};
     wxSpinCtrlDouble* padding_ {nullptr};
     wxSpinCtrl* blurRadius_ {nullptr};
+    wxCheckBox* proceduralBg_ {nullptr};
+    wxCheckBox* bgGrain_ {nullptr};
+    wxCheckBox* extendWidth_ {nullptr};
+    wxStaticText* renditionsLabel_ {nullptr};
+    wxTextCtrl* renditions_ {nullptr};
+    wxStaticText* alsoWriteLabel_ {nullptr};
+    wxCheckBox* alsoExtend_ {nullptr};
+    wxCheckBox* alsoMask_ {nullptr};
+    wxCheckBox* alsoAutoFit_ {nullptr};
     wxStaticText* whiteThrLabel_ {nullptr};
     wxStaticText* paddingLabel_ {nullptr};
     wxComboBox* scaleBox_ {nullptr};
@@ -95,11 +114,15 @@ private:
     wxSpinCtrl* morphKernel_ {nullptr};
     wxSpinCtrl* dilateIters_ {nullptr};
     wxSpinCtrl* erodeIters_ {nullptr};
+    wxCheckBox* fastMorph_ {nullptr};
+    wxSpinCtrl* maskWorkSize_ {nullptr};
     wxCheckBox* whiteCycAssist_ {nullptr};
     wxSpinCtrl* whiteThrMask_ {nullptr};
     wxSpinCtrl* minArea_ {nullptr};
     wxSpinCtrl* featherRadiusMask_ {nullptr};
     wxCheckBox* invertMask_ {nullptr};
+    wxCheckBox* maskRoi_ {nullptr};
+    wxComboBox* maskFormat_ {nullptr};
 
     wxTextCtrl* outputFolder_ {nullptr};
     wxButton* browseBtn_ {nullptr};
@@ -5,8 +5,13 @@
 #include "WxControlPanel.hpp"
 #include "WxPreviewPanel.hpp"
 #include "extend_canvas.hpp"
+#include "renditions.hpp"
 #include "auto_fit_vehicle.hpp"
 #include "vehicle_mask.hpp"
+#include "mask_io.hpp"
+#include "frame_job.hpp"
+#include "film_develop.hpp"
+#include "util/Blend.hpp"
 #include <opencv2/opencv.hpp>
 #include <array>
 #include <random>
@@ -56,10 +61,7 @@ WxMainFrame::WxMainFrame(wxWindow* parent)
             if (controls_->getMode() == ProcessingMode::FilmDevelop)
             {
                 wxString texPath = controls_->getSelectedTexturePath();
-                if (!texPath.IsEmpty()) preview_->UpdatePreviewDevelop(
-                    currentImagePath_, texPath,
-                    controls_->getDevelopBlendMode(), controls_->getDevelopOpacity(),
-                    controls_->getUseTextureLuminance(), controls_->getSwapRB());
+                if (!texPath.IsEmpty()) preview_->UpdatePreviewDevelop(currentImagePath_, texPath, controls_->getDevelopSettings());
                 else preview_->UpdatePreview(currentImagePath_, imageSettings_[currentImagePath_], ProcessingMode::ExtendCanvas, controls_->getMaskSettings());
             }
             else
@@ -95,10 +97,7 @@ WxMainFrame::WxMainFrame(wxWindow* parent)
         if (controls_->getMode() == ProcessingMode::FilmDevelop)
         {
             wxString texPath = controls_->getSelectedTexturePath();
-            if (!texPath.IsEmpty()) preview_->UpdatePreviewDevelop(
-                currentImagePath_, texPath,
-                controls_->getDevelopBlendMode(), controls_->getDevelopOpacity(),
-                controls_->getUseTextureLuminance(), controls_->getSwapRB());
+            if (!texPath.IsEmpty()) preview_->UpdatePreviewDevelop(currentImagePath_, texPath, controls_->getDevelopSettings());
             else preview_->UpdatePreview(currentImagePath_, imageSettings_[currentImagePath_], ProcessingMode::ExtendCanvas, controls_->getMaskSettings());
         }
         else
@@ -161,6 +160,37 @@ WxMainFrame::WxMainFrame(wxWindow* parent)
             }
         }
         int scale = controls_->getScaleFactor();
+        // Rendition set (Extend Canvas only): every size from one decode/detection per file
+        RenditionSet renditionSet;
+        if (controls_->getMode() == ProcessingMode::ExtendCanvas && !controls_->getRenditionSpec().IsEmpty())
+        {
+            std::string err;
+            if (!parseRenditionSet(std::string(controls_->getRenditionSpec().mb_str()), renditionSet, &err) || renditionSet.empty())
+            {
+                preview_->SetStatus("Invalid renditions: " + wxString::FromUTF8(err.c_str()), true);
+                return;
+            }
+        }
+        // Several outputs per file: decode, mask and detection are shared through one FrameJob
+        const std::vector<ProcessingMode> outputModes = controls_->getBatchOutputModes();
+        const bool fanOut = outputModes.size() > 1;
+        const MaskSettings maskSettings = controls_->getMaskSettings();
+        const MaskFormat maskFormat = controls_->getMaskFormat();
+        const wxString maskSuffix = wxString::FromUTF8(maskFileSuffix(maskFormat).c_str());
+        // Single-mode masks go to the worker pool in batches rather than one script launch per file
+        std::vector<bool> batchMasks;
+        if (!fanOut && controls_->getMode() == ProcessingMode::VehicleMask)
+        {
+            preview_->SetStatus(wxString::Format("Generating %zu masks...", batch.size()));
+            std::vector<std::pair<std::string, std::string>> items;
+            for (auto& file : batch)
+            {
+                wxFileName inFn(file);
+                items.emplace_back(std::string(file.mb_str()),
+                                   std::string(wxFileName(outDir, inFn.GetName() + maskSuffix).GetFullPath().mb_str()));
+            }
+            batchMasks = generateVehicleMasks(items, maskSettings, maskFormat);
+        }
         int processed = 0, ok = 0;
         for (auto& file : batch)
         {
@@ -180,9 +210,66 @@ WxMainFrame::WxMainFrame(wxWindow* parent)
             int finalW = s.finalWidth > 0 ? s.finalWidth * scale : -1;
             int finalH = s.finalHeight > 0 ? s.finalHeight * scale : -1;
             bool success = false;
-            if (controls_->getMode() == ProcessingMode::ExtendCanvas)
+            if (fanOut)
+            {
+                FrameJob job(std::string(file.mb_str()));
+                wxFileName inFn(file);
+                const wxString sizeTag = scale > 1 ? wxString::Format("_%dx", scale) : wxString();
+                bool allOk = !job.image().empty();
+                for (ProcessingMode m : outputModes)
+                {
+                    if (!allOk) break;
+                    if (m == ProcessingMode::ExtendCanvas)
+                    {
+                        const ExtendBounds* bounds = job.extendBounds(s.whiteThreshold);
+                        if (!bounds) { allOk = false; break; }
+                        if (!renditionSet.empty())
+                        {
+                            wxString outBase = wxFileName(outDir, inFn.GetFullName()).GetFullPath();
+                            int written = writeRenditions(job.image(), s, renditionSet, std::string(outBase.mb_str()), bounds);
+                            allOk = written == static_cast<int>(renditionSet.renditions.size());
+                            continue;
+                        }
+                        ImageSettings es = s;
+                        es.width = rw; es.height = rh; es.finalWidth = finalW; es.finalHeight = finalH;
+                        cv::Mat out;
+                        wxString outName = inFn.GetName() + "_extended" + sizeTag + "." + inFn.GetExt();
+                        allOk = extendCanvasMat(job.image(), out, es, *bounds) &&
+                                cv::imwrite(std::string(wxFileName(outDir, outName).GetFullPath().mb_str()), out);
+                    }
+                    else if (m == ProcessingMode::VehicleMask)
+                    {
+                        // Decoded frame goes to the mask workers in shared memory; the mask is shared with Auto Fit
+                        const cv::Mat& vmask = job.vehicleMask(maskSettings);
+                        wxString outName = inFn.GetName() + maskSuffix;
+                        allOk = !vmask.empty() &&
+                                writeMask(std::string(wxFileName(outDir, outName).GetFullPath().mb_str()), vmask, maskFormat, &job.image());
+                    }
+                    else if (m == ProcessingMode::AutoFitVehicle)
+                    {
+                        cv::Mat out;
+                        wxString outName = inFn.GetName() + "_autofit" + sizeTag + "." + inFn.GetExt();
+                        allOk = autoFitVehicleMat(job.image(), job.vehicleMask(maskSettings), out, rw, rh, s) &&
+                                cv::imwrite(std::string(wxFileName(outDir, outName).GetFullPath().mb_str()), out);
+                    }
+                }
+                success = allOk;
+                if (success) ++ok;
+            }
+            else if (controls_->getMode() == ProcessingMode::ExtendCanvas && !renditionSet.empty())
+            {
+                // Rendition sizes are absolute; the scale factor does not apply
+                wxFileName inFn(file);
+                wxString outBase = wxFileName(outDir, inFn.GetFullName()).GetFullPath();
+                int written = writeRenditions(std::string(file.mb_str()), s, renditionSet, std::string(outBase.mb_str()));
+                success = written == static_cast<int>(renditionSet.renditions.size());
+                if (success) ++ok;
+            }
+            else if (controls_->getMode() == ProcessingMode::ExtendCanvas)
             {
-                success = extendCanvas(std::string(file.mb_str()), rw, rh, s.whiteThreshold, s.padding, finalW, finalH, s.blurRadius);
+                ImageSettings es = s;
+                es.width = rw; es.height = rh; es.finalWidth = finalW; es.finalHeight = finalH;
+                success = extendCanvas(std::string(file.mb_str()), es);
                 if (success)
                 {
                     wxFileName inFn(file);
@@ -211,13 +298,8 @@ WxMainFrame::WxMainFrame(wxWindow* parent)
             }
             else if (controls_->getMode() == ProcessingMode::VehicleMask)
             {
-                // Vehicle Mask mode
-                wxFileName inFn(file);
-                wxString outName = inFn.GetName() + "_mask.png"; // always PNG
-                wxString finalPath = wxFileName(outDir, outName).GetFullPath();
-                // Ensure output directory exists (already ensured above)
-                // Call shared mask generator (implemented to call an external SAM2 script)
-                success = generateVehicleMask(std::string(file.mb_str()), std::string(finalPath.mb_str()), controls_->getMaskSettings());
+                // Vehicle Mask mode: written by generateVehicleMasks above in the chosen mask format
+                success = batchMasks[processed];
                 if (success) ++ok;
             }
             else if (controls_->getMode() == ProcessingMode::Crop)
@@ -321,8 +403,7 @@ WxMainFrame::WxMainFrame(wxWindow* parent)
     // Film Develop: apply random texture with random blend + opacity to current image
     controls_->Bind(wxEVT_WXUI_DEVELOP_REQUESTED, [this](wxCommandEvent&){
         if (currentImagePath_.IsEmpty()) { preview_->SetStatus("No image selected", true); return; }
-        wxArrayString textures = controls_->getTextureFiles();
-        if (textures.IsEmpty()) { preview_->SetStatus("No textures added", true); return; }
+        // No texture files: the selected path is a procedural one
         wxString outDir = controls_->getOutputFolder();
         if (outDir.IsEmpty()) { preview_->SetStatus("No output folder selected", true); return; }
         // Ensure output folder
@@ -332,173 +413,39 @@ WxMainFrame::WxMainFrame(wxWindow* parent)
         }
 
         // Choose parameters either from controls or randomized per toggle
-        wxString texPath = controls_->getSelectedTexturePath();
-        int mode = controls_->getDevelopBlendMode();
-        float opacity = controls_->getDevelopOpacity();
         if (controls_->getRandomizeOnDevelop())
         {
             // Randomize using control panel helper to keep UI in sync
             controls_->RandomizeDevelopParams();
-            texPath = controls_->getSelectedTexturePath();
-            mode = controls_->getDevelopBlendMode();
-            opacity = controls_->getDevelopOpacity();
         }
+        const wxString texPath = controls_->getSelectedTexturePath();
+        const DevelopSettings develop = controls_->getDevelopSettings();
 
-        // Load base and texture
+        // Load base and texture, develop at full resolution
         cv::Mat base = cv::imread(std::string(currentImagePath_.mb_str()), cv::IMREAD_COLOR);
         if (base.empty()) { preview_->SetStatus("Failed to load base image", true); return; }
-        cv::Mat tex = cv::imread(std::string(texPath.mb_str()), cv::IMREAD_UNCHANGED);
-        if (tex.empty()) { preview_->SetStatus("Failed to load texture", true); return; }
-
-        // Resize texture to base size
-        if (tex.cols != base.cols || tex.rows != base.rows) {
-            cv::resize(tex, tex, cv::Size(base.cols, base.rows), 0, 0, cv::INTER_LANCZOS4);
-        }
-
-        // Keep blending in BGR (OpenCV native)
-        cv::Mat texBGR, alpha;
-        switch (tex.channels()) {
-            case 4: {
-                std::vector<cv::Mat> ch; cv::split(tex, ch); // BGRA
-                // Try BGRA->BGR first; correct later if RGBA is detected by heuristic
-                cv::cvtColor(tex, texBGR, cv::COLOR_BGRA2BGR);
-                // Base alpha from A channel
-                const double aInv = (ch[3].depth() == CV_16U) ? (1.0/65535.0) : (1.0/255.0);
-                cv::Mat alphaFromA; ch[3].convertTo(alphaFromA, CV_32F, aInv);
-                if (controls_->getUseTextureLuminance()) {
-                    // Use luminance as alpha, neutralize color to gray, and respect original A
-                    cv::Mat gray; cv::cvtColor(texBGR, gray, cv::COLOR_BGR2GRAY);
-                    const double invMaxTex = (texBGR.depth() == CV_16U) ? (1.0/65535.0) : (1.0/255.0);
-                    cv::Mat alphaFromLuma; gray.convertTo(alphaFromLuma, CV_32F, invMaxTex);
-                    alpha = alphaFromLuma.mul(alphaFromA);
-                    cv::cvtColor(gray, texBGR, cv::COLOR_GRAY2BGR);
-                } else {
-                    alpha = alphaFromA;
-                }
-                break;
-            }
-            case 3: {
-                texBGR = tex;
-                if (controls_->getUseTextureLuminance()) {
-                    // Derive alpha from luminance AND neutralize texture color to avoid strong tints
-                    cv::Mat gray; cv::cvtColor(texBGR, gray, cv::COLOR_BGR2GRAY);
-                    const double invMaxTex = (texBGR.depth() == CV_16U) ? (1.0/65535.0) : (1.0/255.0);
-                    gray.convertTo(alpha, CV_32F, invMaxTex);
-                    cv::cvtColor(gray, texBGR, cv::COLOR_GRAY2BGR);
-                } else {
-                    alpha = cv::Mat(base.rows, base.cols, CV_32F, cv::Scalar(1.0));
-                }
-                break;
-            }
-            case 1:
-            default: {
-                if (controls_->getUseTextureLuminance()) {
-                    tex.convertTo(alpha, CV_32F, 1.0/255.0);
-                } else {
-                    alpha = cv::Mat(base.rows, base.cols, CV_32F, cv::Scalar(1.0));
-                }
-                cv::cvtColor(tex, texBGR, cv::COLOR_GRAY2BGR);
-                break;
-            }
-        }
-        // Apply flags similar to preview
-        if (controls_->getSwapRB()) { std::vector<cv::Mat> ch; cv::split(texBGR, ch); std::swap(ch[0], ch[2]); cv::merge(ch, texBGR); }
-        else {
-            auto isBlueDominant = [](const cv::Mat& bgr){
-                if (bgr.empty()) return false;
-                cv::Mat gray; cv::cvtColor(bgr, gray, cv::COLOR_BGR2GRAY);
-                cv::Mat mask; cv::threshold(gray, mask, 32, 255, cv::THRESH_BINARY);
-                if (cv::countNonZero(mask) < (bgr.rows * bgr.cols) / 200) return false;
-                cv::Scalar mB = cv::mean(bgr, mask);
-                double mb = mB[0], mg = mB[1], mr = mB[2];
-                return mb > 1.3 * std::max(1e-6, mr) && mb > 1.3 * std::max(1e-6, mg);
-            };
-            bool fixed = false;
-            if (tex.channels() == 4) {
-                if (isBlueDominant(texBGR)) {
-                    cv::Mat alt; cv::cvtColor(tex, alt, cv::COLOR_RGBA2BGR);
-                    if (!isBlueDominant(alt)) { texBGR = alt; fixed = true; }
-                }
-            } else if (tex.channels() == 3) {
-                if (isBlueDominant(texBGR)) {
-                    std::vector<cv::Mat> ch; cv::split(texBGR, ch); std::swap(ch[0], ch[2]); cv::Mat alt; cv::merge(ch, alt);
-                    if (!isBlueDominant(alt)) { texBGR = alt; fixed = true; }
-                }
-            }
-            (void)fixed;
-        }
-
-        // Auto-neutralize color for black-background JPG textures when luminance is not explicitly requested
-        if (!controls_->getUseTextureLuminance()) {
-            cv::Mat gray; cv::cvtColor(texBGR, gray, cv::COLOR_BGR2GRAY);
-            cv::Mat bgMask; cv::threshold(gray, bgMask, 16, 255, cv::THRESH_BINARY_INV);
-            double bgRatio = double(cv::countNonZero(bgMask)) / double(texBGR.rows * texBGR.cols);
-            cv::Mat fgMask; cv::threshold(gray, fgMask, 32, 255, cv::THRESH_BINARY);
-            int fgCount = cv::countNonZero(fgMask);
-            if (fgCount > (texBGR.rows * texBGR.cols) / 200) {
-                cv::Scalar m = cv::mean(texBGR, fgMask);
-                double mb = m[0], mg = m[1], mr = m[2];
-                double spread = std::max({ std::abs(mb - mr), std::abs(mb - mg), std::abs(mg - mr) });
-                if (bgRatio > 0.4 && spread > 5.0) {
-                    const double invMaxTex = (texBGR.depth() == CV_16U) ? (1.0/65535.0) : (1.0/255.0);
-                    gray.convertTo(alpha, CV_32F, invMaxTex);
-                    cv::cvtColor(gray, texBGR, cv::COLOR_GRAY2BGR);
-                }
-            }
-        }
-        // When Use texture luminance is enabled, we use luminance as per-pixel alpha (set above), not as replacement color.
-        // Convert to float [0,1] with proper scaling for bit depth
-        cv::Mat baseF, texF;
-        {
-            const double invMaxBase = (base.depth() == CV_16U) ? (1.0/65535.0) : (1.0/255.0);
-            base.convertTo(baseF, CV_32F, invMaxBase);
-        }
-        {
-            const double invMaxTex = (texBGR.depth() == CV_16U) ? (1.0/65535.0) : (1.0/255.0);
-            texBGR.convertTo(texF, CV_32F, invMaxTex);
-        }
-
-        // Blend mode implementations (explicit per-channel)
-        std::vector<cv::Mat> a(3), b(3), c(3);
-        cv::split(baseF, a);
-        cv::split(texF, b);
-        switch (mode) {
-            case 0: // Multiply
-                for (int i=0;i<3;++i) cv::multiply(a[i], b[i], c[i]);
-                break;
-            case 1: // Screen
-                for (int i=0;i<3;++i) {
-                    cv::Mat one = cv::Mat::ones(a[i].size(), a[i].type());
-                    c[i] = one - (one - a[i]).mul(one - b[i]);
-                }
-                break;
-            default: // Lighten
-                for (int i=0;i<3;++i) c[i] = cv::max(a[i], b[i]);
-                break;
-        }
-        cv::Mat blended; cv::merge(c, blended);
-
-        // Effective per-pixel alpha: texture alpha * random opacity
-        cv::Mat alpha3; cv::Mat alphaScaled = alpha * opacity; cv::Mat chs[] = {alphaScaled, alphaScaled, alphaScaled};
-        cv::merge(chs, 3, alpha3);
-        cv::Mat resultF = baseF.mul(1.0 - alpha3) + blended.mul(alpha3);
-        cv::Mat result8BGR; resultF = cv::min(cv::max(resultF, 0), 1);
-        resultF.convertTo(result8BGR, CV_8U, 255.0);
+        // Prepared once per texture and size, then reused by later develops
+        auto texture = cachedDevelopTexture(std::string(texPath.mb_str()), base.size(), develop);
+        if (!texture) { preview_->SetStatus("Failed to load texture", true); return; }
+        const DevelopTexture& prepared = *texture;
+        cv::Mat result8BGR;
+        developBlend(base, prepared, develop, result8BGR);
 
         // Optional debug dump when WX_DEV_DEBUG=1
         if (const char* dbg = std::getenv("WX_DEV_DEBUG"); dbg && std::string(dbg) == "1") {
             auto pTex = wxFileName(outDir, "debug_tex.jpg").GetFullPath();
             auto pAlpha = wxFileName(outDir, "debug_alpha.png").GetFullPath();
             auto pBlend = wxFileName(outDir, "debug_blended.jpg").GetFullPath();
-            cv::Mat alpha8; cv::Mat alphaClamped = cv::min(cv::max(alpha, 0), 1); alphaClamped.convertTo(alpha8, CV_8U, 255.0);
-            cv::Mat blended8; blended.convertTo(blended8, CV_8U, 255.0);
-            cv::imwrite(std::string(pTex.mb_str()), texBGR);
+            cv::Mat alpha8(base.size(), CV_8U, cv::Scalar(255));
+            if (!prepared.alpha.empty()) prepared.alpha.convertTo(alpha8, CV_8U, prepared.alpha.depth() == CV_16U ? 1.0/257.0 : 1.0);
+            cv::Mat blended8; util::blendTexture(base, prepared.bgr, cv::Mat(), blended8, develop.blendMode, 1.0f);
+            cv::imwrite(std::string(pTex.mb_str()), prepared.bgr);
             cv::imwrite(std::string(pAlpha.mb_str()), alpha8);
             cv::imwrite(std::string(pBlend.mb_str()), blended8);
             // Print channel means over bright pixels of texture for diagnosis
-            cv::Mat gray; cv::cvtColor(texBGR, gray, cv::COLOR_BGR2GRAY);
+            cv::Mat gray; cv::cvtColor(prepared.bgr, gray, cv::COLOR_BGR2GRAY);
             cv::Mat mask; cv::threshold(gray, mask, 32, 255, cv::THRESH_BINARY);
-            cv::Scalar m = cv::mean(texBGR, mask);
+            cv::Scalar m = cv::mean(prepared.bgr, mask);
             std::cout << "[Develop Debug] Texture BGR mean over bright pixels: B=" << m[0] << " G=" << m[1] << " R=" << m[2] << std::endl;
         }
 
@@ -508,9 +455,9 @@ WxMainFrame::WxMainFrame(wxWindow* parent)
         wxString finalPath = wxFileName(outDir, outName).GetFullPath();
         bool ok = cv::imwrite(std::string(finalPath.mb_str()), result8BGR);
         if (ok) {
-            preview_->SetStatus(wxString::Format("Developed: %s (mode %d, %.0f%%)", wxFileName(finalPath).GetFullName(), mode, opacity*100.0f), false);
+            preview_->SetStatus(wxString::Format("Developed: %s (mode %d, %.0f%%)", wxFileName(finalPath).GetFullName(), develop.blendMode, develop.opacity*100.0f), false);
             // Update preview to match what we saved
-            preview_->UpdatePreviewDevelop(currentImagePath_, texPath, mode, opacity, controls_->getUseTextureLuminance(), controls_->getSwapRB());
+            preview_->UpdatePreviewDevelop(currentImagePath_, texPath, develop);
         } else {
             preview_->SetStatus("Failed to save developed image", true);
         }
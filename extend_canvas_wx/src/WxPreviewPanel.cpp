@@ -9,19 +9,58 @@
 #include <algorithm>
 #include <cmath>
 #include <cstring>
+#include <map>
 #include "vehicle_mask.hpp"
+#include "mask_cache.hpp"
+#include "extend_canvas.hpp"
+#include "auto_fit_vehicle.hpp"
+#include "film_develop.hpp"
 
 using namespace cv;
 
+// Film Develop preview inputs at display resolution
+struct WxPreviewPanel::DevelopProxy
+{
+    wxString basePath;
+    wxSize box;
+    cv::Size fullSize;
+    cv::Mat base;
+};
+
+struct WxPreviewPanel::CollageRender
+{
+    // Each slot's source resampled to its size on a layer, and where it was last placed (layer
+    // coordinates, unclipped); resampled again only when the source or size changes
+    struct Slot
+    {
+        wxString path;
+        cv::Mat scaled;
+        cv::Rect placed;
+    };
+    // The composite at `scale` x canvas size, so a slot edit only repaints what it touched
+    struct Layer
+    {
+        double scale {1.0};
+        std::vector<Slot> slots;
+        cv::Mat composite;
+    };
+    Layer full;    // canvas resolution: built on release, after a pause and for export
+    Layer display; // screen resolution: built while dragging and zooming
+    bool displayStale {true};
+    std::map<wxString, std::pair<cv::Mat, double>> proxies; // downscaled sources for the display layer, and their scale
+    std::vector<int> pending; // slots edited on the display layer since the last full render
+};
+
 wxBEGIN_EVENT_TABLE(WxPreviewPanel, wxPanel)
     EVT_SIZE(WxPreviewPanel::OnSize)
 wxEND_EVENT_TABLE()
 
 WxPreviewPanel::WxPreviewPanel(wxWindow* parent)
-    : wxPanel(parent), overlayHideTimer_(this)
+    : wxPanel(parent), overlayHideTimer_(this), collageCommitTimer_(this)
 {
     BuildUI();
     overlayHideTimer_.Bind(wxEVT_TIMER, [this](wxTimerEvent&){ overlay_->Hide(); });
+    collageCommitTimer_.Bind(wxEVT_TIMER, [this](wxTimerEvent&){ CommitCollageInteraction(); });
 }
 
 void WxPreviewPanel::BuildUI()
@@ -70,13 +109,20 @@ void WxPreviewPanel::BuildUI()
     SetSizer(root);
 }
 
-void WxPreviewPanel::LayoutImages()
+wxSize WxPreviewPanel::DisplayBox() const
 {
-    // Fit images within each column's visible width and overall height
+    // Each column's visible width and the overall height
     wxSize client = scroll_->GetClientSize();
     int gutters = 60; // approximate padding + gaps
-    int availWPerPanel = std::max(120, (client.x - gutters) / 2);
-    int availH = std::max(120, client.y - 60);
+    return wxSize(std::max(120, (client.x - gutters) / 2), std::max(120, client.y - 60));
+}
+
+void WxPreviewPanel::LayoutImages()
+{
+    // Fit images within each column's visible width and overall height
+    const wxSize box = DisplayBox();
+    int availWPerPanel = box.x;
+    int availH = box.y;
 
     auto scaleMatToFit = [&](const cv::Mat& bgr){
         if (bgr.empty()) return wxBitmap();
@@ -85,7 +131,8 @@ void WxPreviewPanel::LayoutImages()
         double s = std::min(sx, sy);
         int nw = std::max(1, int(bgr.cols * s));
         int nh = std::max(1, int(bgr.rows * s));
-        cv::Mat resized; cv::resize(bgr, resized, cv::Size(nw, nh), 0, 0, cv::INTER_LANCZOS4);
+        cv::Mat resized = bgr; // screen-resolution collage layers already fit
+        if (nw != bgr.cols || nh != bgr.rows) cv::resize(bgr, resized, cv::Size(nw, nh), 0, 0, cv::INTER_LANCZOS4);
         cv::Mat rgb; cv::cvtColor(resized, rgb, cv::COLOR_BGR2RGB);
         size_t size = static_cast<size_t>(rgb.cols) * static_cast<size_t>(rgb.rows) * 3;
         unsigned char* buf = new unsigned char[size];
@@ -94,9 +141,14 @@ void WxPreviewPanel::LayoutImages()
         return wxBitmap(wi);
     };
 
+    wxBitmap originalBm;
     if (originalMat_) {
-        wxBitmap bm = scaleMatToFit(*originalMat_);
-        originalCanvas_->SetImage(bm, wxSize(originalMat_->cols, originalMat_->rows));
+        originalBm = scaleMatToFit(*originalMat_);
+        // Collage layers may be at screen resolution; the canvas maps clicks in canvas pixels
+        const wxSize origSize = currentMode_ == ProcessingMode::SplitCollage
+            ? wxSize(std::max(2, collageCanvasSize_.GetWidth()), std::max(2, collageCanvasSize_.GetHeight()))
+            : wxSize(originalMat_->cols, originalMat_->rows);
+        originalCanvas_->SetImage(originalBm, origSize);
     } else if (originalCache_.IsOk()) {
         // Cache already in wxBitmap form; but we still want to ensure it fits the panel width/height
         // Convert cache back to Mat-like scaling via wxImage to keep path uniform
@@ -108,7 +160,10 @@ void WxPreviewPanel::LayoutImages()
         originalCanvas_->SetImage(bm, wxSize(originalCache_.GetWidth(), originalCache_.GetHeight()));
     }
 
-    if (resultMat_) {
+    if (resultMat_ && originalMat_ && resultMat_->data == originalMat_->data && resultMat_->size() == originalMat_->size()) {
+        // Collage: both views show the same composite
+        resultBmp_->SetBitmap(originalBm);
+    } else if (resultMat_) {
         resultBmp_->SetBitmap(scaleMatToFit(*resultMat_));
     } else if (resultCache_.IsOk()) {
         // Keep cached bitmap, but if it's oversized it will still be displayed; re-scaling ensures fit
@@ -136,6 +191,7 @@ void WxPreviewPanel::OnSize(wxSizeEvent&)
 
 void WxPreviewPanel::UpdatePreview(const wxString& imagePath, const ImageSettings& settings, ProcessingMode mode, const MaskSettings mask)
 {
+    const ProcessingMode prevMode = currentMode_;
     currentMode_ = mode;
     currentImagePath_ = imagePath;
 
@@ -173,8 +229,11 @@ void WxPreviewPanel::UpdatePreview(const wxString& imagePath, const ImageSetting
         return;
     }
 
-    // Load original (for preview-only) and build processed result entirely in memory
-    cv::Mat img = cv::imread(std::string(imagePath.mb_str()));
+    // Load original (for preview-only) and build processed result entirely in memory.
+    // While tuning a mask on the same file, reuse the decoded frame so only the changed stages rerun.
+    const bool sameMaskSource = mode == ProcessingMode::VehicleMask && prevMode == ProcessingMode::VehicleMask &&
+                                maskPipeline_ && maskPipelinePath_ == imagePath && originalMat_;
+    cv::Mat img = sameMaskSource ? maskPipeline_->image() : cv::imread(std::string(imagePath.mb_str()));
     if (img.empty()) { SetStatus("Failed to load image", true); return; }
 
     // Helper: deep-copy convert Mat(BGR) -> wxBitmap (RGB)
@@ -189,10 +248,13 @@ void WxPreviewPanel::UpdatePreview(const wxString& imagePath, const ImageSetting
 
     // Convert to wxBitmap for original
     // Keep full-res mats for high-quality display scaling
-    if (originalMat_) { delete originalMat_; originalMat_ = nullptr; }
-    originalMat_ = new cv::Mat(img.clone());
-    originalCache_ = toWxBitmap(img);
-    originalTitle_->SetLabel("Original (" + wxString::Format("%dx%d", originalCache_.GetWidth(), originalCache_.GetHeight()) + ")");
+    if (!sameMaskSource)
+    {
+        if (originalMat_) { delete originalMat_; originalMat_ = nullptr; }
+        originalMat_ = new cv::Mat(img.clone());
+        originalCache_ = toWxBitmap(img);
+        originalTitle_->SetLabel("Original (" + wxString::Format("%dx%d", originalCache_.GetWidth(), originalCache_.GetHeight()) + ")");
+    }
     if (originalCanvas_) {
         originalCanvas_->SetCollageMode(false);
         originalCanvas_->EnableOverlay(mode == ProcessingMode::Crop || mode == ProcessingMode::Splitter);
@@ -202,14 +264,22 @@ void WxPreviewPanel::UpdatePreview(const wxString& imagePath, const ImageSetting
     // If in Vehicle Mask mode, build a mask preview using provided settings and return
     if (mode == ProcessingMode::VehicleMask)
     {
-        // Prepare preview bitmaps
-        if (originalMat_) { delete originalMat_; originalMat_ = nullptr; }
-        originalMat_ = new cv::Mat(img.clone());
-        originalCache_ = toWxBitmap(img);
-        originalTitle_->SetLabel("Original (" + wxString::Format("%dx%d", originalCache_.GetWidth(), originalCache_.GetHeight()) + ")");
-        // Compute mask via shared logic for consistency
-        extern bool computeVehicleMaskMat(const cv::Mat&, cv::Mat&, const MaskSettings&);
-        cv::Mat maskImg; computeVehicleMaskMat(img, maskImg, mask);
+        // Compute mask via shared logic for consistency; the pipeline keeps the intermediate stages.
+        // A mask cached for this file and these settings skips it; only fresh files are stored, not every tuning step.
+        const std::string key = maskcache::fileKey(std::string(imagePath.mb_str()));
+        cv::Mat maskImg;
+        if (maskcache::load(key, mask, maskcache::kHeuristic, maskImg) && maskImg.size() == img.size())
+        {
+            // The pipeline holds another frame (or none): stop tuning from it
+            if (!sameMaskSource) { if (maskPipeline_) maskPipeline_->clear(); maskPipelinePath_.clear(); }
+        }
+        else
+        {
+            if (!maskPipeline_) maskPipeline_ = std::make_shared<VehicleMaskPipeline>();
+            maskPipelinePath_ = imagePath;
+            maskPipeline_->compute(img, maskImg, mask);
+            if (!sameMaskSource) maskcache::store(key, mask, maskcache::kHeuristic, maskImg);
+        }
         cv::Mat mask3; cv::cvtColor(maskImg, mask3, cv::COLOR_GRAY2BGR);
         if (resultMat_) { delete resultMat_; resultMat_ = nullptr; }
         resultMat_ = new cv::Mat(mask3.clone());
@@ -220,105 +290,22 @@ void WxPreviewPanel::UpdatePreview(const wxString& imagePath, const ImageSetting
         return;
     }
 
-    // Auto Fit Vehicle: detect vehicle, scale/center with optional stretch fill
+    // Auto Fit Vehicle: same engine as export, on the cached mask; tuning steps are not stored, export stores
     if (mode == ProcessingMode::AutoFitVehicle)
     {
         cv::Mat maskImg;
-        if (!computeVehicleMaskMat(img, maskImg, mask)) { SetStatus("Vehicle not found", true); return; }
-        std::vector<std::vector<cv::Point>> contours; cv::findContours(maskImg, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
-        if (contours.empty()) { SetStatus("Vehicle not found", true); return; }
-        size_t best = 0; double bestA = 0.0; for (size_t i=0;i<contours.size();++i){ double a = cv::contourArea(contours[i]); if (a>bestA){bestA=a;best=i;} }
-        cv::Rect bbox = cv::boundingRect(contours[best]);
-        int canvasW = settings.width > 0 ? settings.width : img.cols;
-        int canvasH = settings.height > 0 ? settings.height : img.rows;
-        int carW = std::max(1, bbox.width), carH = std::max(1, bbox.height);
-        double p = std::max(0.0, settings.padding);
-        double sx = double(canvasW) / (carW * (1.0 + 2.0 * p));
-        double sy = double(canvasH) / (carH * (1.0 + 2.0 * p));
-        double s = std::min(sx, sy); if (s <= 0.0) s = 1.0;
-        int scaledW = std::max(1, int(img.cols * s + 0.5));
-        int scaledH = std::max(1, int(img.rows * s + 0.5));
-        cv::Mat scaled; cv::resize(img, scaled, cv::Size(scaledW, scaledH), 0,0, cv::INTER_LANCZOS4);
-        double cx = (bbox.x + bbox.width * 0.5) * s; double cy = (bbox.y + bbox.height * 0.5) * s;
-        int offX = int(canvasW * 0.5 - cx + 0.5); int offY = int(canvasH * 0.5 - cy + 0.5);
-        cv::Mat canvas(canvasH, canvasW, img.type(), cv::Scalar(255,255,255));
-        if (settings.stretchIfNeeded)
-        {
-            int topGap = std::max(0, offY);
-            int botGap = std::max(0, canvasH - (offY + scaled.rows));
-            cv::Mat topSrc = (bbox.y > 0) ? img.rowRange(0, bbox.y) : cv::Mat();
-            cv::Mat botSrc = (bbox.y + bbox.height < img.rows) ? img.rowRange(bbox.y + bbox.height, img.rows) : cv::Mat();
-            auto makeStripH = [](const cv::Mat& src, int newH, int W){ if (newH<=0) return cv::Mat(); if (!src.empty()){ cv::Mat d; cv::resize(src, d, cv::Size(W, newH), 0,0, cv::INTER_AREA); return d; } return cv::Mat(newH, W, CV_8UC3, cv::Scalar(255,255,255)); };
-            cv::Mat topStrip = makeStripH(topSrc, topGap, canvasW);
-            cv::Mat botStrip = makeStripH(botSrc, botGap, canvasW);
-            if (settings.blurRadius > 0){ int k = std::max(1, settings.blurRadius*2+1); if(!topStrip.empty()) cv::GaussianBlur(topStrip, topStrip, cv::Size(k,k), 0); if(!botStrip.empty()) cv::GaussianBlur(botStrip, botStrip, cv::Size(k,k), 0);}            
-            if (!topStrip.empty()) { topStrip.copyTo(canvas.rowRange(0, topStrip.rows)); }
-            if (!botStrip.empty()) { botStrip.copyTo(canvas.rowRange(canvasH - botStrip.rows, canvasH)); }
-        }
-        int x0 = std::max(0, offX), y0 = std::max(0, offY);
-        int x1 = std::min(canvasW, offX + scaled.cols), y1 = std::min(canvasH, offY + scaled.rows);
-        if (x1 > x0 && y1 > y0)
-        {
-            cv::Rect dstR(x0, y0, x1 - x0, y1 - y0);
-            cv::Rect srcR(x0 - offX, y0 - offY, dstR.width, dstR.height);
-            scaled(srcR).copyTo(canvas(dstR));
-        }
+        if (!cachedVehicleMaskMat(std::string(imagePath.mb_str()), img, maskImg, mask, false)) { SetStatus("Vehicle not found", true); return; }
+        cv::Mat canvas;
+        if (!autoFitVehicleMat(img, maskImg, canvas, settings.width, settings.height, settings)) { SetStatus("Vehicle not found", true); return; }
         if (resultMat_) { delete resultMat_; resultMat_ = nullptr; }
-        resultMat_ = new cv::Mat(canvas.clone());
-        auto toWxBitmap2 = [](const cv::Mat& bgr){ cv::Mat rgb; cv::cvtColor(bgr, rgb, cv::COLOR_BGR2RGB); const size_t size = (size_t)rgb.cols * (size_t)rgb.rows * 3; unsigned char* buf = new unsigned char[size]; std::memcpy(buf, rgb.data, size); wxImage wi(rgb.cols, rgb.rows, buf, false); return wxBitmap(wi); };
-        resultCache_ = toWxBitmap2(canvas);
+        resultMat_ = new cv::Mat(canvas);
+        resultCache_ = toWxBitmap(canvas);
         resultTitle_->SetLabel("Auto Fit Vehicle Preview (" + wxString::Format("%dx%d", canvas.cols, canvas.rows) + ")");
         LayoutImages();
         ShowOverlay(wxString::FromUTF8("Preview"), wxColour(100, 100, 100), 600);
         return;
     }
 
-    // Helper lambdas replicating core logic (no disk I/O)
-    auto centerSampleThreshold = [](const Mat& im, int stripeH = 20, int stripeW = 40){
-        int cx = im.cols / 2;
-        int w  = std::min({ stripeW, std::max(1, cx - 1), std::max(1, im.cols - cx - 1) });
-        int h  = std::min(stripeH, std::max(1, im.rows / 10));
-        Rect topR(cx - w, 0, 2*w + 1, h);
-        Rect botR(cx - w, im.rows - h, 2*w + 1, h);
-        Mat gt, gb; cvtColor(im(topR), gt, COLOR_BGR2GRAY); cvtColor(im(botR), gb, COLOR_BGR2GRAY);
-        double mt = mean(gt)[0], mb = mean(gb)[0];
-        int thr = int(std::min(mt, mb) - 5.0); thr = std::clamp(thr, 180, 250); return thr;
-    };
-    auto findForegroundBounds = [](const Mat& im, int& top, int& bot, int whiteThr){
-        Mat mask; inRange(im, Scalar(whiteThr,whiteThr,whiteThr), Scalar(255,255,255), mask);
-        bitwise_not(mask, mask);
-        reduce(mask, mask, 1, REDUCE_MAX, CV_8U);
-        top = bot = -1; for (int r=0;r<mask.rows;++r){ if (mask.at<uchar>(r,0)){ if (top==-1) top=r; bot=r; } }
-        return top != -1;
-    };
-    auto findForegroundBoundsX = [](const Mat& im, int& left, int& right, int whiteThr){
-        Mat mask; inRange(im, Scalar(whiteThr,whiteThr,whiteThr), Scalar(255,255,255), mask);
-        bitwise_not(mask, mask);
-        reduce(mask, mask, 0, REDUCE_MAX, CV_8U);
-        left = right = -1; for (int c=0;c<mask.cols;++c){ if (mask.at<uchar>(0,c)){ if (left==-1) left=c; right=c; } }
-        return left != -1;
-    };
-    auto makeStrip = [](const Mat& src, int newH, int W){
-        if (newH <= 0) return Mat();
-        if (!src.empty()){ Mat dst; resize(src, dst, Size(W,newH), 0,0, INTER_AREA); return dst; }
-        return Mat(newH, W, CV_8UC3, Scalar(255,255,255));
-    };
-    auto applyFinalResize = [](const Mat& canvas, int reqW, int reqH){
-        if (reqW <= 0 || reqH <= 0) return canvas.clone();
-        double sx = double(reqW)/canvas.cols, sy = double(reqH)/canvas.rows; double s = std::min(sx, sy);
-        int nw = std::max(1, int(canvas.cols * s + 0.5)); int nh = std::max(1, int(canvas.rows * s + 0.5));
-        Mat resized; resize(canvas, resized, Size(nw, nh), 0,0, INTER_LANCZOS4);
-        Mat final(reqH, reqW, canvas.type(), Scalar(255,255,255));
-        int x = (reqW - nw)/2; int y = (reqH - nh)/2; resized.copyTo(final(Rect(x,y,nw,nh))); return final;
-    };
-    auto blendSeam = [](Mat& img, int seamX, int overlap){
-        if (overlap <= 0) return;
-        if (seamX - overlap < 0 || seamX + overlap > img.cols) return;
-        Mat left = img(Rect(seamX - overlap, 0, overlap, img.rows)).clone();
-        Mat right = img(Rect(seamX, 0, overlap, img.rows)).clone();
-        for (int i=0;i<overlap;++i){ double a = (i+1.0)/(overlap+1.0); Mat dst = img(Rect(seamX - overlap + i, 0, 1, img.rows)); addWeighted(right.col(i), a, left.col(i), 1.0 - a, 0.0, dst); }
-    };
-
     // Splitter preview: show N-panel split guidelines and scaled crop
     if (mode == ProcessingMode::Splitter)
     {
@@ -443,121 +430,9 @@ void WxPreviewPanel::UpdatePreview(const wxString& imagePath, const ImageSetting
         return;
     }
 
-    int thr = (settings.whiteThreshold >= 0 && settings.whiteThreshold <= 255)
-              ? settings.whiteThreshold : centerSampleThreshold(img);
-    int fgTop, fgBot; if (!findForegroundBounds(img, fgTop, fgBot, thr)) { SetStatus("Foreground not found", true); return; }
-    int carH = fgBot - fgTop + 1;
-    int pad  = int(carH * settings.padding + 0.5);
-    int cropTop = std::max(0, fgTop - pad);
-    int cropBot = std::min(img.rows - 1, fgBot + pad);
-    Mat carReg = img.rowRange(cropTop, cropBot + 1);
-
-    int desiredW = settings.width > 0 ? settings.width : img.cols;
-    int desiredH = settings.height > 0 ? settings.height : img.rows;
-    int W = img.cols;
-
-    // Horizontal crop metrics (for building left/right extension strips later)
-    int fgLeft = 0, fgRight = img.cols - 1; findForegroundBoundsX(img, fgLeft, fgRight, thr);
-    int carW = std::max(1, fgRight - fgLeft + 1);
-    int padX = int(carW * settings.padding + 0.5);
-    int cropLeft = std::max(0, fgLeft - padX);
-    int cropRight = std::min(img.cols - 1, fgRight + padX);
-
+    // Same engine as the batch export (vertical or 2-D extension, procedural strips, final resize)
     Mat result;
-    if (desiredH <= carReg.rows)
-    {
-        int yOff = (carReg.rows - desiredH) / 2; result = carReg.rowRange(yOff, yOff + desiredH).clone();
-        if (false && desiredW > result.cols)
-        {
-            // Extend horizontally instead of scaling up
-            int extraW = desiredW - result.cols; int leftW = extraW/2; int rightW = extraW - leftW;
-            auto makeStripW = [](const Mat& src, int H, int newW){
-                if (newW <= 0) return Mat();
-                if (!src.empty()){ Mat dst; resize(src, dst, Size(newW, H), 0,0, INTER_AREA); return dst; }
-                return Mat(H, newW, CV_8UC3, Scalar(255,255,255));
-            };
-            Mat leftSrc = (cropLeft > 0) ? img.colRange(0, cropLeft) : Mat();
-            Mat rightSrc = (cropRight + 1 < img.cols) ? img.colRange(cropRight + 1, img.cols) : Mat();
-            Mat leftStrip = makeStripW(leftSrc, result.rows, leftW);
-            Mat rightStrip = makeStripW(rightSrc, result.rows, rightW);
-            if (settings.blurRadius > 0)
-            { int k = std::max(1, settings.blurRadius*2+1); if(!leftStrip.empty()) GaussianBlur(leftStrip, leftStrip, Size(k,k), 0); if(!rightStrip.empty()) GaussianBlur(rightStrip, rightStrip, Size(k,k), 0); }
-            Mat wide(desiredH, desiredW, img.type()); int x = 0;
-            if (!leftStrip.empty()) { leftStrip.copyTo(wide(Rect(x,0,leftStrip.cols,leftStrip.rows))); x += leftStrip.cols; }
-            result.copyTo(wide(Rect(x,0,result.cols,result.rows))); x += result.cols;
-            if (!rightStrip.empty()) { rightStrip.copyTo(wide(Rect(x,0,rightStrip.cols,rightStrip.rows))); }
-            if (!leftStrip.empty()) { int seamX = leftStrip.cols; int ov = std::min({24, leftStrip.cols, wide.cols - seamX}); blendSeam(wide, seamX, ov); }
-            if (!rightStrip.empty()) { int seamX = wide.cols - rightStrip.cols; int ov = std::min({24, rightStrip.cols, seamX}); blendSeam(wide, seamX, ov); }
-            result = wide;
-        }
-        if (desiredW != result.cols)
-        {
-            double scale = double(desiredW) / result.cols; int sh = int(result.rows * scale + 0.5);
-            resize(result, result, Size(desiredW, sh), 0,0, INTER_LANCZOS4);
-            if (sh != desiredH)
-            {
-                if (sh > desiredH)
-                { int y = (sh - desiredH)/2; result = result.rowRange(y, y+desiredH).clone(); }
-                else
-                { Mat ext(desiredH, desiredW, result.type(), Scalar(255,255,255)); int y = (desiredH - sh)/2; result.copyTo(ext.rowRange(y, y+sh)); result = ext; }
-            }
-        }
-    }
-    else
-    {
-        int extra = desiredH - carReg.rows; int topH = extra/2; int botH = extra - topH; int targetW = W;
-        Mat scaledCarReg = carReg;
-        Mat scaledTopSrc, scaledBotSrc;
-        // Pre-scale to target width whenever it differs
-        if (desiredW != W)
-        {
-            double sc = double(desiredW)/W; int sh = int(carReg.rows * sc + 0.5);
-            resize(carReg, scaledCarReg, Size(desiredW, sh), 0,0, INTER_LANCZOS4);
-            Mat topSrc = cropTop > 0 ? img.rowRange(0, cropTop) : Mat();
-            Mat botSrc = (cropBot + 1 < img.rows) ? img.rowRange(cropBot + 1, img.rows) : Mat();
-            if (!topSrc.empty()){ int sth = int(topSrc.rows * sc + 0.5); resize(topSrc, scaledTopSrc, Size(desiredW, sth), 0,0, INTER_LANCZOS4); }
-            if (!botSrc.empty()){ int sbh = int(botSrc.rows * sc + 0.5); resize(botSrc, scaledBotSrc, Size(desiredW, sbh), 0,0, INTER_LANCZOS4); }
-            extra = desiredH - scaledCarReg.rows; topH = extra/2; botH = extra - topH;
-            targetW = desiredW;
-        }
-        else
-        {
-            scaledTopSrc = cropTop > 0 ? img.rowRange(0, cropTop) : Mat();
-            scaledBotSrc = (cropBot + 1 < img.rows) ? img.rowRange(cropBot + 1, img.rows) : Mat();
-            targetW = W;
-        }
-        Mat topStrip = makeStrip(scaledTopSrc, topH, targetW);
-        Mat botStrip = makeStrip(scaledBotSrc, botH, targetW);
-        if (settings.blurRadius > 0)
-        { int k = std::max(1, settings.blurRadius*2+1); if(!topStrip.empty()) GaussianBlur(topStrip, topStrip, Size(k,k), 0); if(!botStrip.empty()) GaussianBlur(botStrip, botStrip, Size(k,k), 0); }
-        result.create(desiredH, targetW, img.type()); int y=0; if(!topStrip.empty()){ topStrip.copyTo(result.rowRange(y, y+topStrip.rows)); y+=topStrip.rows; }
-        scaledCarReg.copyTo(result.rowRange(y, y+scaledCarReg.rows)); y+=scaledCarReg.rows; if(!botStrip.empty()) botStrip.copyTo(result.rowRange(y, y+botStrip.rows));
-
-        // No horizontal extension
-        if (false && desiredW > result.cols)
-        {
-            int extraW = desiredW - result.cols; int leftW = extraW/2; int rightW = extraW - leftW;
-            auto makeStripW = [](const Mat& src, int H, int newW){
-                if (newW <= 0) return Mat();
-                if (!src.empty()){ Mat dst; resize(src, dst, Size(newW, H), 0,0, INTER_AREA); return dst; }
-                return Mat(H, newW, CV_8UC3, Scalar(255,255,255));
-            };
-            Mat leftSrc = (cropLeft > 0) ? img.colRange(0, cropLeft) : Mat();
-            Mat rightSrc = (cropRight + 1 < img.cols) ? img.colRange(cropRight + 1, img.cols) : Mat();
-            Mat leftStrip = makeStripW(leftSrc, result.rows, leftW);
-            Mat rightStrip = makeStripW(rightSrc, result.rows, rightW);
-            if (settings.blurRadius > 0)
-            { int k = std::max(1, settings.blurRadius*2+1); if(!leftStrip.empty()) GaussianBlur(leftStrip, leftStrip, Size(k,k), 0); if(!rightStrip.empty()) GaussianBlur(rightStrip, rightStrip, Size(k,k), 0); }
-            Mat wide(desiredH, desiredW, img.type()); int x = 0;
-            if (!leftStrip.empty()) { leftStrip.copyTo(wide(Rect(x,0,leftStrip.cols,leftStrip.rows))); x += leftStrip.cols; }
-            result.copyTo(wide(Rect(x,0,result.cols,result.rows))); x += result.cols;
-            if (!rightStrip.empty()) { rightStrip.copyTo(wide(Rect(x,0,rightStrip.cols,rightStrip.rows))); }
-            // seam blend no-op (feature disabled)
-            result = wide;
-        }
-    }
-    // Final resize if provided
-    result = applyFinalResize(result, settings.finalWidth, settings.finalHeight);
+    if (!extendCanvasMat(img, result, settings)) { SetStatus("Foreground not found", true); return; }
 
     // Convert to wxBitmap (deep copy) and store full-res mat
     if (resultMat_) { delete resultMat_; resultMat_ = nullptr; }
@@ -570,18 +445,47 @@ void WxPreviewPanel::UpdatePreview(const wxString& imagePath, const ImageSetting
 
 void WxPreviewPanel::UpdatePreviewDevelop(const wxString& imagePath,
                                           const wxString& texturePath,
-                                          int blendMode,
-                                          float opacity,
-                                          bool useTextureLuminance,
-                                          bool swapRBTexture)
+                                          const DevelopSettings& develop)
 {
     currentMode_ = ProcessingMode::FilmDevelop;
     currentImagePath_ = imagePath;
+    if (!developProxy_) developProxy_ = std::make_shared<DevelopProxy>();
+    DevelopProxy& px = *developProxy_;
+
+    // Display-sized proxy of the base, decoded once per file and panel size
+    const wxSize box = DisplayBox();
+    if (px.basePath != imagePath || px.box != box || px.base.empty())
+    {
+        cv::Mat full = cv::imread(std::string(imagePath.mb_str()), cv::IMREAD_COLOR);
+        if (full.empty()) { SetStatus("Failed to load image", true); return; }
+        px = DevelopProxy();
+        px.basePath = imagePath;
+        px.box = box;
+        px.fullSize = full.size();
+        const double s = std::min({ 1.0, double(box.x) / full.cols, double(box.y) / full.rows });
+        const cv::Size proxySize(std::max(1, int(full.cols * s + 0.5)), std::max(1, int(full.rows * s + 0.5)));
+        if (proxySize == full.size()) px.base = full;
+        else cv::resize(full, px.base, proxySize, 0, 0, cv::INTER_AREA);
+    }
+
+    // Texture at proxy size from the prepared-texture cache, coloured as the export at the full size
+    // would be; blend mode and opacity changes only re-blend
+    auto texture = cachedDevelopTexture(std::string(texturePath.mb_str()), px.base.size(), develop, cv::INTER_AREA,
+                                        px.fullSize);
+    if (!texture) { SetStatus("Failed to load texture", true); return; }
 
-    // Load base image
-    cv::Mat base = cv::imread(std::string(imagePath.mb_str()), cv::IMREAD_COLOR);
-    if (base.empty()) { SetStatus("Failed to load image", true); return; }
-    // Convert to wx for original panel
+    // Optional debug diagnostics for preview
+    if (const char* dbg = std::getenv("WX_DEV_DEBUG"); dbg && std::string(dbg) == "1") {
+        cv::Mat gray; cv::cvtColor(texture->bgr, gray, cv::COLOR_BGR2GRAY);
+        cv::Mat mask; cv::threshold(gray, mask, 32, 255, cv::THRESH_BINARY);
+        cv::Scalar m = cv::mean(texture->bgr, mask);
+        std::cout << "[Preview Develop Debug] Texture BGR mean over bright pixels: B=" << m[0] << " G=" << m[1] << " R=" << m[2] << std::endl;
+    }
+
+    cv::Mat result8BGR;
+    developBlend(px.base, *texture, develop, result8BGR);
+
+    // Convert to wx for display
     auto toWxBitmap = [](const cv::Mat& bgr){
         cv::Mat rgb; cv::cvtColor(bgr, rgb, cv::COLOR_BGR2RGB);
         const size_t size = static_cast<size_t>(rgb.cols) * static_cast<size_t>(rgb.rows) * 3;
@@ -591,168 +495,18 @@ void WxPreviewPanel::UpdatePreviewDevelop(const wxString& imagePath,
         return wxBitmap(wi);
     };
     if (originalMat_) { delete originalMat_; originalMat_ = nullptr; }
-    originalMat_ = new cv::Mat(base.clone());
-    originalCache_ = toWxBitmap(base);
-    originalTitle_->SetLabel("Original (" + wxString::Format("%dx%d", originalCache_.GetWidth(), originalCache_.GetHeight()) + ")");
+    originalMat_ = new cv::Mat(px.base);
+    originalCache_ = toWxBitmap(px.base);
+    originalTitle_->SetLabel("Original (" + wxString::Format("%dx%d", px.fullSize.width, px.fullSize.height) + ")");
     if (originalCanvas_) {
         originalCanvas_->EnableOverlay(false);
         originalCanvas_->SetGuides(0, 0);
     }
 
-    // Load texture (may be RGBA) and normalize channels
-    cv::Mat tex = cv::imread(std::string(texturePath.mb_str()), cv::IMREAD_UNCHANGED);
-    if (tex.empty()) { SetStatus("Failed to load texture", true); return; }
-    if (tex.cols != base.cols || tex.rows != base.rows) {
-        cv::resize(tex, tex, cv::Size(base.cols, base.rows), 0, 0, cv::INTER_LANCZOS4);
-    }
-
-    // Keep blending in BGR (OpenCV native) to avoid channel confusion
-    cv::Mat texBGR, alpha;
-    switch (tex.channels()) {
-        case 4: {
-            std::vector<cv::Mat> ch; cv::split(tex, ch); // BGRA
-            // Try BGRA->BGR first. Some backends may deliver RGBA; we correct later if detected.
-            cv::cvtColor(tex, texBGR, cv::COLOR_BGRA2BGR);
-            // Alpha from texture alpha by default
-            const double aInv = (ch[3].depth() == CV_16U) ? (1.0/65535.0) : (1.0/255.0);
-            cv::Mat alphaFromA; ch[3].convertTo(alphaFromA, CV_32F, aInv);
-            if (useTextureLuminance) {
-                // Derive luminance and neutralize texture color. Combine with existing alpha to preserve cutouts
-                cv::Mat gray; cv::cvtColor(texBGR, gray, cv::COLOR_BGR2GRAY);
-                const double invMaxTex = (texBGR.depth() == CV_16U) ? (1.0/65535.0) : (1.0/255.0);
-                cv::Mat alphaFromLuma; gray.convertTo(alphaFromLuma, CV_32F, invMaxTex);
-                alpha = alphaFromLuma.mul(alphaFromA); // keep original transparency
-                cv::cvtColor(gray, texBGR, cv::COLOR_GRAY2BGR); // neutral color for blending
-            } else {
-                alpha = alphaFromA;
-            }
-            break;
-        }
-        case 3: {
-            texBGR = tex;
-            if (useTextureLuminance) {
-                // Derive alpha from luminance AND remove color cast from texture for neutral blending
-                cv::Mat gray; cv::cvtColor(texBGR, gray, cv::COLOR_BGR2GRAY);
-                const double invMaxTex = (texBGR.depth() == CV_16U) ? (1.0/65535.0) : (1.0/255.0);
-                gray.convertTo(alpha, CV_32F, invMaxTex);
-                cv::cvtColor(gray, texBGR, cv::COLOR_GRAY2BGR);
-            } else {
-                alpha = cv::Mat(base.rows, base.cols, CV_32F, cv::Scalar(1.0));
-            }
-            break;
-        }
-        case 1:
-        default: {
-            // Single channel: use channel as alpha when requested; color from gray-to-BGR for blending color
-            if (useTextureLuminance) {
-                tex.convertTo(alpha, CV_32F, 1.0/255.0);
-            } else {
-                alpha = cv::Mat(base.rows, base.cols, CV_32F, cv::Scalar(1.0));
-            }
-            cv::cvtColor(tex, texBGR, cv::COLOR_GRAY2BGR);
-            break;
-        }
-    }
-    // Optional processing on texture
-    if (swapRBTexture) {
-        std::vector<cv::Mat> ch; cv::split(texBGR, ch); std::swap(ch[0], ch[2]); cv::merge(ch, texBGR);
-    } else {
-        // Heuristic auto-fix: evaluate dominance on bright pixels (ignore near-black background)
-        auto isBlueDominant = [](const cv::Mat& bgr){
-            if (bgr.empty()) return false;
-            cv::Mat gray; cv::cvtColor(bgr, gray, cv::COLOR_BGR2GRAY);
-            // Mask of bright pixels (avoid dark background bias)
-            cv::Mat mask; cv::threshold(gray, mask, 32, 255, cv::THRESH_BINARY);
-            if (cv::countNonZero(mask) < (bgr.rows * bgr.cols) / 200) return false; // not enough signal
-            cv::Scalar mB = cv::mean(bgr, mask);
-            double mb = mB[0], mg = mB[1], mr = mB[2];
-            return mb > 1.3 * std::max(1e-6, mr) && mb > 1.3 * std::max(1e-6, mg);
-        };
-        bool fixed = false;
-        if (tex.channels() == 4) {
-            if (isBlueDominant(texBGR)) {
-                cv::Mat alt; cv::cvtColor(tex, alt, cv::COLOR_RGBA2BGR);
-                if (!isBlueDominant(alt)) { texBGR = alt; fixed = true; }
-            }
-        } else if (tex.channels() == 3) {
-            if (isBlueDominant(texBGR)) {
-                std::vector<cv::Mat> ch; cv::split(texBGR, ch); std::swap(ch[0], ch[2]); cv::Mat alt; cv::merge(ch, alt);
-                if (!isBlueDominant(alt)) { texBGR = alt; fixed = true; }
-            }
-        }
-        (void)fixed; // no-op; kept for future logging if desired
-    }
-
-    // Auto-neutralize color for black-background JPG textures when luminance is not explicitly requested
-    if (!useTextureLuminance) {
-        cv::Mat gray; cv::cvtColor(texBGR, gray, cv::COLOR_BGR2GRAY);
-        cv::Mat bgMask; cv::threshold(gray, bgMask, 16, 255, cv::THRESH_BINARY_INV);
-        double bgRatio = double(cv::countNonZero(bgMask)) / double(texBGR.rows * texBGR.cols);
-        cv::Mat fgMask; cv::threshold(gray, fgMask, 32, 255, cv::THRESH_BINARY);
-        int fgCount = cv::countNonZero(fgMask);
-        if (fgCount > (texBGR.rows * texBGR.cols) / 200) {
-            cv::Scalar m = cv::mean(texBGR, fgMask);
-            double mb = m[0], mg = m[1], mr = m[2];
-            double spread = std::max({ std::abs(mb - mr), std::abs(mb - mg), std::abs(mg - mr) });
-            if (bgRatio > 0.4 && spread > 5.0) {
-                // Treat bright content as signal: derive alpha from luminance and neutralize color
-                const double invMaxTex = (texBGR.depth() == CV_16U) ? (1.0/65535.0) : (1.0/255.0);
-                gray.convertTo(alpha, CV_32F, invMaxTex);
-                cv::cvtColor(gray, texBGR, cv::COLOR_GRAY2BGR);
-            }
-        }
-    }
-
-    // Optional debug diagnostics for preview
-    if (const char* dbg = std::getenv("WX_DEV_DEBUG"); dbg && std::string(dbg) == "1") {
-        cv::Mat gray; cv::cvtColor(texBGR, gray, cv::COLOR_BGR2GRAY);
-        cv::Mat mask; cv::threshold(gray, mask, 32, 255, cv::THRESH_BINARY);
-        cv::Scalar m = cv::mean(texBGR, mask);
-        std::cout << "[Preview Develop Debug] Texture BGR mean over bright pixels: B=" << m[0] << " G=" << m[1] << " R=" << m[2] << std::endl;
-    }
-    // Note: when useTextureLuminance is enabled, we now use luminance as per-pixel alpha (set above),
-    // and preserve texture color for blending.
-    // Convert to float [0,1] with correct scaling for bit depth
-    cv::Mat baseF, texF;
-    {
-        const double invMaxBase = (base.depth() == CV_16U) ? (1.0/65535.0) : (1.0/255.0);
-        base.convertTo(baseF, CV_32F, invMaxBase);
-    }
-    {
-        const double invMaxTex = (texBGR.depth() == CV_16U) ? (1.0/65535.0) : (1.0/255.0);
-        texBGR.convertTo(texF, CV_32F, invMaxTex);
-    }
-
-    // Blend modes - compute per channel to avoid any broadcasting or type quirks
-    std::vector<cv::Mat> a(3), b(3), c(3);
-    cv::split(baseF, a);
-    cv::split(texF, b);
-    switch (blendMode) {
-        case 0: // Multiply
-            for (int i=0;i<3;++i) cv::multiply(a[i], b[i], c[i]);
-            break;
-        case 1: // Screen
-            for (int i=0;i<3;++i) {
-                cv::Mat one = cv::Mat::ones(a[i].size(), a[i].type());
-                c[i] = one - (one - a[i]).mul(one - b[i]);
-            }
-            break;
-        default: // Lighten
-            for (int i=0;i<3;++i) c[i] = cv::max(a[i], b[i]);
-            break;
-    }
-    cv::Mat blended; cv::merge(c, blended);
-
-    cv::Mat alpha3; cv::Mat alphaScaled = alpha * std::clamp(opacity, 0.0f, 1.0f);
-    cv::Mat chs[] = {alphaScaled, alphaScaled, alphaScaled};
-    cv::merge(chs, 3, alpha3);
-    cv::Mat resultF = baseF.mul(1.0 - alpha3) + blended.mul(alpha3);
-    cv::Mat result8BGR; resultF = cv::min(cv::max(resultF, 0), 1); resultF.convertTo(result8BGR, CV_8U, 255.0);
-
     if (resultMat_) { delete resultMat_; resultMat_ = nullptr; }
-    resultMat_ = new cv::Mat(result8BGR.clone());
+    resultMat_ = new cv::Mat(result8BGR);
     resultCache_ = toWxBitmap(result8BGR);
-    resultTitle_->SetLabel(wxString::Format("Develop Preview (mode %d, %.0f%%)", blendMode, opacity*100.0f));
+    resultTitle_->SetLabel(wxString::Format("Develop Preview (mode %d, %.0f%%)", develop.blendMode, develop.opacity*100.0f));
     LayoutImages();
     ShowOverlay(wxString::FromUTF8("Preview"), wxColour(100, 100, 100), 600);
 }
@@ -932,82 +686,212 @@ void WxPreviewPanel::ClampCollageSlot(CollageSlotState& slot, const wxRect& slot
     slot.offsetY = std::clamp(slot.offsetY, minCy - slotCenterY, maxCy - slotCenterY);
 }
 
-void WxPreviewPanel::RebuildCollageComposite()
+bool WxPreviewPanel::RebuildCollageLayer(bool display, int dirtySlot)
 {
     int canvasW = std::max(2, collageCanvasSize_.GetWidth());
     int canvasH = std::max(2, collageCanvasSize_.GetHeight());
-    cv::Mat canvas(canvasH, canvasW, CV_8UC3, cv::Scalar(18, 18, 18));
+    const double scale = display ? CollageDisplayScale() : 1.0;
+    const bool native = scale >= 1.0;
+    const int layerW = native ? canvasW : std::max(1, static_cast<int>(std::round(canvasW * scale)));
+    const int layerH = native ? canvasH : std::max(1, static_cast<int>(std::round(canvasH * scale)));
+    const cv::Rect layerRect(0, 0, layerW, layerH);
+    const cv::Scalar background(18, 18, 18);
 
     auto rects = GetCollageSlotRectsImage();
     size_t slotCount = std::min(collageSlots_.size(), rects.size());
     size_t srcCount = collageSources_.GetCount();
-
+    if (!collageRender_) collageRender_ = std::make_shared<CollageRender>();
+    CollageRender::Layer& layer = display ? collageRender_->display : collageRender_->full;
+    auto& renders = layer.slots;
+    cv::Mat& composite = layer.composite;
+    renders.resize(slotCount);
+
+    const bool full = dirtySlot < 0 || static_cast<size_t>(dirtySlot) >= slotCount || layer.scale != scale ||
+                      composite.cols != layerW || composite.rows != layerH;
+    layer.scale = scale;
+    cv::Rect dirty = full ? layerRect : renders[dirtySlot].placed;
+    bool changed = full;
+
+    // Placement in layer coordinates; resampling only where the source or size changed. A dirty pass
+    // touches only its slot, so the others keep the placement last painted for them
     for (size_t i = 0; i < slotCount; ++i)
     {
+        if (!full && static_cast<int>(i) != dirtySlot) continue;
         auto& slot = collageSlots_[i];
-        if (srcCount == 0 || slot.sourceIndex < 0 || static_cast<size_t>(slot.sourceIndex) >= srcCount)
+        auto& render = renders[i];
+        const cv::Rect before = render.placed;
+        std::shared_ptr<cv::Mat> imgPtr;
+        if (srcCount > 0 && slot.sourceIndex >= 0 && static_cast<size_t>(slot.sourceIndex) < srcCount)
+            imgPtr = LoadCollageImage(slot.imagePath);
+        if (!imgPtr || imgPtr->empty())
         {
-            continue;
+            render = CollageRender::Slot();
+        }
+        else
+        {
+            const cv::Mat& img = *imgPtr;
+            const wxRect& slotRect = rects[i];
+            double baseScale = std::max(
+                double(slotRect.GetWidth()) / std::max(1, img.cols),
+                double(slotRect.GetHeight()) / std::max(1, img.rows));
+            slot.scale = std::clamp(slot.scale, 0.1, 6.0);
+            double actualScale = baseScale * slot.scale;
+            actualScale = std::clamp(actualScale, baseScale * 0.1, baseScale * 6.0);
+
+            ClampCollageSlot(slot, slotRect, img, actualScale);
+
+            int dstW = std::max(1, static_cast<int>(std::round(img.cols * actualScale)));
+            int dstH = std::max(1, static_cast<int>(std::round(img.rows * actualScale)));
+            double slotCenterX = slotRect.GetX() + slotRect.GetWidth() / 2.0;
+            double slotCenterY = slotRect.GetY() + slotRect.GetHeight() / 2.0;
+            double cx = slotCenterX + slot.offsetX;
+            double cy = slotCenterY + slot.offsetY;
+
+            cv::Rect placed(static_cast<int>(std::round(cx - dstW / 2.0)), static_cast<int>(std::round(cy - dstH / 2.0)), dstW, dstH);
+            if (!native)
+            {
+                placed = cv::Rect(static_cast<int>(std::round((cx - dstW / 2.0) * scale)),
+                                  static_cast<int>(std::round((cy - dstH / 2.0) * scale)),
+                                  std::max(1, static_cast<int>(std::round(dstW * scale))),
+                                  std::max(1, static_cast<int>(std::round(dstH * scale))));
+            }
+            if (render.path != slot.imagePath || render.scaled.cols != placed.width || render.scaled.rows != placed.height)
+            {
+                if (native)
+                {
+                    cv::resize(img, render.scaled, placed.size(), 0, 0, cv::INTER_LANCZOS4);
+                }
+                else
+                {
+                    // From a cached proxy, so the cost follows the on-screen footprint, not the source
+                    const cv::Mat& proxy = CollageProxy(slot.imagePath, img, double(placed.width) / img.cols);
+                    const bool shrink = placed.width < proxy.cols;
+                    cv::resize(proxy, render.scaled, placed.size(), 0, 0, shrink ? cv::INTER_AREA : cv::INTER_LINEAR);
+                }
+                render.path = slot.imagePath;
+                if (static_cast<int>(i) == dirtySlot) changed = true;
+            }
+            render.placed = placed;
+        }
+        if (!full && static_cast<int>(i) == dirtySlot)
+        {
+            if (render.placed != before) changed = true;
+            dirty |= render.placed;
         }
-        auto imgPtr = LoadCollageImage(slot.imagePath);
-        if (!imgPtr || imgPtr->empty()) continue;
-
-        const cv::Mat& img = *imgPtr;
-        const wxRect& slotRect = rects[i];
-        double baseScale = std::max(
-            double(slotRect.GetWidth()) / std::max(1, img.cols),
-            double(slotRect.GetHeight()) / std::max(1, img.rows));
-        slot.scale = std::clamp(slot.scale, 0.1, 6.0);
-        double actualScale = baseScale * slot.scale;
-        actualScale = std::clamp(actualScale, baseScale * 0.1, baseScale * 6.0);
-
-        ClampCollageSlot(slot, slotRect, img, actualScale);
-
-        int dstW = std::max(1, static_cast<int>(std::round(img.cols * actualScale)));
-        int dstH = std::max(1, static_cast<int>(std::round(img.rows * actualScale)));
-        cv::Mat resized; cv::resize(img, resized, cv::Size(dstW, dstH), 0, 0, cv::INTER_LANCZOS4);
-
-        double slotCenterX = slotRect.GetX() + slotRect.GetWidth() / 2.0;
-        double slotCenterY = slotRect.GetY() + slotRect.GetHeight() / 2.0;
-        double cx = slotCenterX + slot.offsetX;
-        double cy = slotCenterY + slot.offsetY;
-        int x0 = static_cast<int>(std::round(cx - dstW / 2.0));
-        int y0 = static_cast<int>(std::round(cy - dstH / 2.0));
-
-        int roiX = std::max(0, x0);
-        int roiY = std::max(0, y0);
-        int srcX = std::max(0, -x0);
-        int srcY = std::max(0, -y0);
-        int roiW = std::min(dstW - srcX, canvasW - roiX);
-        int roiH = std::min(dstH - srcY, canvasH - roiY);
-        if (roiW <= 0 || roiH <= 0) continue;
-
-        cv::Rect dstRect(roiX, roiY, roiW, roiH);
-        cv::Rect srcRect(srcX, srcY, roiW, roiH);
-        resized(srcRect).copyTo(canvas(dstRect));
     }
+    if (!changed) return false;
 
-    auto toWxBitmap = [](const cv::Mat& bgr)
+    // Repaint the dirty region in slot order, so overlaps come out exactly as a full rebuild
+    if (full) composite.create(layerH, layerW, CV_8UC3);
+    dirty &= layerRect;
+    if (dirty.area() > 0)
     {
-        cv::Mat rgb; cv::cvtColor(bgr, rgb, cv::COLOR_BGR2RGB);
-        size_t size = static_cast<size_t>(rgb.cols) * static_cast<size_t>(rgb.rows) * 3;
-        unsigned char* buf = new unsigned char[size];
-        std::memcpy(buf, rgb.data, size);
-        wxImage wi(rgb.cols, rgb.rows, buf, false);
-        return wxBitmap(wi);
-    };
+        composite(dirty).setTo(background);
+        for (const auto& render : renders)
+        {
+            if (render.scaled.empty()) continue;
+            const cv::Rect area = render.placed & dirty;
+            if (area.area() <= 0) continue;
+            render.scaled(area - render.placed.tl()).copyTo(composite(area));
+        }
+    }
+    return true;
+}
 
+const cv::Mat& WxPreviewPanel::CollageProxy(const wxString& path, const cv::Mat& img, double scale)
+{
+    if (scale >= 1.0) return img;
+    auto& proxy = collageRender_->proxies[path];
+    if (proxy.first.empty() || proxy.second < scale)
+    {
+        // Twice the current need, so zooming in a little further reuses it
+        const double s = std::min(1.0, scale * 2.0);
+        if (s >= 1.0) proxy = { img, 1.0 };
+        else
+        {
+            const cv::Size size(std::max(1, static_cast<int>(std::round(img.cols * s))), std::max(1, static_cast<int>(std::round(img.rows * s))));
+            cv::resize(img, proxy.first, size, 0, 0, cv::INTER_AREA);
+            proxy.second = double(size.width) / img.cols;
+        }
+    }
+    return proxy.first;
+}
+
+double WxPreviewPanel::CollageDisplayScale() const
+{
+    // The scale LayoutImages fits the canvas at
+    const wxSize box = DisplayBox();
+    const double sx = double(box.x) / std::max(2, collageCanvasSize_.GetWidth());
+    const double sy = double(box.y) / std::max(2, collageCanvasSize_.GetHeight());
+    return std::clamp(std::min(sx, sy), 0.01, 1.0);
+}
+
+void WxPreviewPanel::ShowCollageLayer(bool display)
+{
+    const cv::Mat& composite = display ? collageRender_->display.composite : collageRender_->full.composite;
+    // Both views show the composite itself: no copies, and LayoutImages scales it once for both
     if (originalMat_) { delete originalMat_; originalMat_ = nullptr; }
     if (resultMat_) { delete resultMat_; resultMat_ = nullptr; }
+    originalMat_ = new cv::Mat(composite);
+    resultMat_ = new cv::Mat(composite);
+    originalCache_ = wxBitmap();
+    resultCache_ = wxBitmap();
+    const int canvasW = std::max(2, collageCanvasSize_.GetWidth());
+    const int canvasH = std::max(2, collageCanvasSize_.GetHeight());
+    originalTitle_->SetLabel(wxString::Format("Collage Layout (%dx%d)", canvasW, canvasH));
+    resultTitle_->SetLabel(wxString::Format("Collage Output (%dx%d)", canvasW, canvasH));
+    RefreshCollageViews();
+}
 
-    originalMat_ = new cv::Mat(canvas.clone());
-    resultMat_ = new cv::Mat(canvas.clone());
-    originalCache_ = toWxBitmap(canvas);
-    resultCache_ = originalCache_;
-    originalTitle_->SetLabel(wxString::Format("Collage Layout (%dx%d)", canvas.cols, canvas.rows));
-    resultTitle_->SetLabel(wxString::Format("Collage Output (%dx%d)", canvas.cols, canvas.rows));
+bool WxPreviewPanel::RebuildCollageComposite(int dirtySlot)
+{
+    collageCommitTimer_.Stop();
+    if (!collageRender_) collageRender_ = std::make_shared<CollageRender>();
+    auto& pending = collageRender_->pending;
+    bool changed = false;
+    if (dirtySlot < 0)
+    {
+        changed = RebuildCollageLayer(false, -1);
+    }
+    else
+    {
+        if (std::find(pending.begin(), pending.end(), dirtySlot) == pending.end()) pending.push_back(dirtySlot);
+        for (int slot : pending) changed |= RebuildCollageLayer(false, slot);
+    }
+    pending.clear();
+    collageRender_->displayStale = true;
+    if (changed) ShowCollageLayer(false);
+    return changed;
+}
 
-    RefreshCollageViews();
+void WxPreviewPanel::UpdateCollageInteractive()
+{
+    const int slot = collageActiveSlot_;
+    if (CollageDisplayScale() >= 1.0)
+    {
+        // The canvas already fits the screen: the full composite is the display one
+        if (RebuildCollageComposite(slot)) LayoutImages();
+        return;
+    }
+    if (!collageRender_) collageRender_ = std::make_shared<CollageRender>();
+    const bool changed = RebuildCollageLayer(true, collageRender_->displayStale ? -1 : slot);
+    collageRender_->displayStale = false;
+    if (!changed) return;
+    auto& pending = collageRender_->pending;
+    if (std::find(pending.begin(), pending.end(), slot) == pending.end()) pending.push_back(slot);
+    ShowCollageLayer(true);
+    LayoutImages();
+    collageCommitTimer_.StartOnce(300); // the wheel has no release: render at full resolution after a pause
+}
+
+void WxPreviewPanel::CommitCollageInteraction()
+{
+    collageCommitTimer_.Stop();
+    if (currentMode_ != ProcessingMode::SplitCollage || !collageRender_ || collageRender_->pending.empty()) return;
+    for (int slot : collageRender_->pending) RebuildCollageLayer(false, slot);
+    collageRender_->pending.clear();
+    ShowCollageLayer(false);
+    LayoutImages();
 }
 
 void WxPreviewPanel::RefreshCollageViews()
@@ -1044,8 +928,8 @@ void WxPreviewPanel::MoveActiveCollageSlot(const wxPoint2DDouble& deltaImage)
     auto& slot = collageSlots_[collageActiveSlot_];
     slot.offsetX += deltaImage.m_x;
     slot.offsetY += deltaImage.m_y;
-    RebuildCollageComposite();
-    LayoutImages();
+    // Panning re-blits the cached slot at screen resolution; a drag into the clamp changes nothing
+    UpdateCollageInteractive();
 }
 
 void WxPreviewPanel::ScaleActiveCollageSlot(double factor, const wxPoint2DDouble&)
@@ -1055,8 +939,7 @@ void WxPreviewPanel::ScaleActiveCollageSlot(double factor, const wxPoint2DDouble
     auto& slot = collageSlots_[collageActiveSlot_];
     slot.scale *= factor;
     slot.scale = std::clamp(slot.scale, 0.1, 6.0);
-    RebuildCollageComposite();
-    LayoutImages();
+    UpdateCollageInteractive();
 }
 
 void WxPreviewPanel::CycleActiveCollageSlot(int direction)
@@ -1073,7 +956,7 @@ void WxPreviewPanel::CycleActiveCollageSlot(int direction)
     slot.imagePath = collageSources_[slot.sourceIndex];
     slot.scale = 1.0;
     slot.offsetX = slot.offsetY = 0.0;
-    RebuildCollageComposite();
+    RebuildCollageComposite(collageActiveSlot_);
     LayoutImages();
 
     wxString label = wxString::Format("Slot %d: %s", collageActiveSlot_ + 1, wxFileName(slot.imagePath).GetFullName());
@@ -1124,6 +1007,11 @@ void WxPreviewPanel::ClearPreview()
     collageSources_.Clear();
     collageActiveSlot_ = -1;
     collageImageCache_.clear();
+    collageRender_.reset();
+    collageCommitTimer_.Stop();
+    maskPipeline_.reset();
+    maskPipelinePath_.clear();
+    developProxy_.reset();
     originalCache_ = wxBitmap();
     resultCache_ = wxBitmap();
     if (originalCanvas_)
@@ -1419,6 +1307,7 @@ void CropCanvas::OnLeftUp(wxMouseEvent&)
         if (HasCapture()) ReleaseMouse();
         collageDragging_ = false;
         SetCursor(wxCURSOR_ARROW);
+        if (owner_) owner_->CommitCollageInteraction();
         return;
     }
     if (HasCapture()) ReleaseMouse();
@@ -7,11 +7,13 @@
 #include "models/ImageSettings.hpp"
 #include "models/ProcessingMode.hpp"
 #include "models/MaskSettings.hpp"
+#include "models/DevelopSettings.hpp"
 #include <memory>
 #include <map>
 #include <vector>
 
 namespace cv { class Mat; }
+class VehicleMaskPipeline;
 
 class WxPreviewPanel : public wxPanel
 {
@@ -21,12 +23,10 @@ public:
     void UpdatePreview(const wxString& imagePath, const ImageSettings& settings,
                        ProcessingMode mode = ProcessingMode::ExtendCanvas,
                        const MaskSettings mask = MaskSettings());
+    // Runs the film develop engine on a display-sized proxy; the export runs it at full resolution
     void UpdatePreviewDevelop(const wxString& imagePath,
                               const wxString& texturePath,
-                              int blendMode,
-                              float opacity,
-                              bool useTextureLuminance,
-                              bool swapRBTexture);
+                              const DevelopSettings& develop);
     void ClearPreview();
     void SetStatus(const wxString& message, bool isError = false);
     // Crop helpers
@@ -50,10 +50,12 @@ public:
     void ScaleActiveCollageSlot(double factor, const wxPoint2DDouble& anchorImage);
     void CycleActiveCollageSlot(int direction);
     void ChangeActiveCollageSlot(int delta);
+    void CommitCollageInteraction(); // mouse-up: render pending edits at canvas resolution
 
 private:
     void BuildUI();
     void LayoutImages();
+    wxSize DisplayBox() const; // size each image is fitted into
     void ShowOverlay(const wxString& text, const wxColour& color, int durationMs = 1200);
     void OnSize(wxSizeEvent&);
 
@@ -70,6 +72,12 @@ private:
     // Keep full-resolution images for high-quality display rescaling
     cv::Mat* originalMat_ {nullptr};
     cv::Mat* resultMat_ {nullptr};
+    // Vehicle Mask mode: staged mask cache for the current file
+    std::shared_ptr<VehicleMaskPipeline> maskPipeline_;
+    wxString maskPipelinePath_;
+    // Film Develop mode: display-sized base, reused across texture/blend/opacity changes
+    struct DevelopProxy;
+    std::shared_ptr<DevelopProxy> developProxy_;
     wxString currentImagePath_;
     wxString lastResultPath_;
     ProcessingMode currentMode_ { ProcessingMode::ExtendCanvas };
@@ -93,10 +101,23 @@ private:
     int collageActiveSlot_ {-1};
     wxSize collageCanvasSize_ {1080, 1920};
     mutable std::map<wxString, std::shared_ptr<cv::Mat>> collageImageCache_;
+    // Composites at canvas and screen resolution with their per-slot scaled sources, kept between
+    // rebuilds (defined in the .cpp)
+    struct CollageRender;
+    std::shared_ptr<CollageRender> collageRender_;
+    wxTimer collageCommitTimer_;
 
     void EnsureCollageSlotCount(int count);
     void EnsureCollageAssignments();
-    void RebuildCollageComposite();
+    // One layer (canvas or screen resolution); dirtySlot < 0 repaints everything; false when nothing changed
+    bool RebuildCollageLayer(bool display, int dirtySlot);
+    // Canvas-resolution composite, shown; folds in pending screen-resolution edits
+    bool RebuildCollageComposite(int dirtySlot = -1);
+    // Screen-resolution update of the active slot, shown; the full render waits for release or a pause
+    void UpdateCollageInteractive();
+    void ShowCollageLayer(bool display);
+    const cv::Mat& CollageProxy(const wxString& path, const cv::Mat& img, double scale);
+    double CollageDisplayScale() const;
     std::shared_ptr<cv::Mat> LoadCollageImage(const wxString& path) const;
     void ClampCollageSlot(CollageSlotState& slot, const wxRect& slotRect, const cv::Mat& img, double actualScale);
     void RefreshCollageViews();
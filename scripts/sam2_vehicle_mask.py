@@ -2,7 +2,8 @@
 """
 SAM2 Vehicle Mask Generator
 ---------------------------
-CLI: python3 scripts/sam2_vehicle_mask.py --input <image> --output <mask.png>
+CLI:    python3 scripts/sam2_vehicle_mask.py --input <image> --output <mask.png>
+Worker: python3 scripts/sam2_vehicle_mask.py --worker [--allow-heuristic]
 
 This script is a placeholder entry point to integrate Meta's SAM 2.0 for
 segmenting vehicles and producing a black/white mask. It expects a Python
@@ -16,36 +17,307 @@ Notes:
   - If SAM2 or its dependencies are not installed, this script exits with
     a non-zero status so the C++ app can fall back to a heuristic mask.
   - Replace the TODO block below with real SAM2 inference code.
+  - Worker mode keeps the process (and model) alive and serves batches of
+    requests over stdin/stdout; see scripts/README.md for the protocol.
+    --allow-heuristic serves the heuristic below without SAM2 (local stand-in).
+  - When the `image_extender` extension (apps/image_extender_py) is importable,
+    the heuristic and the post-processing run the app's C++ kernels with every
+    MaskSettings field, so masks match the in-process ones exactly. The NumPy
+    fallback always works at full resolution over the whole frame: it ignores
+    working_size and restrict_to_foreground and only matches when they are off.
 """
 import argparse
+import array
+import mmap
 import os
+import socket
+import struct
 import sys
 import cv2
 import numpy as np
 
+try:
+    import image_extender as native
+except ImportError:
+    native = None
+
+
+def sam2_available() -> bool:
+    # TODO: replace with actual SAM2 imports, e.g.:
+    # from sam2 import SamPredictor, sam2_model_from_cfg
+    # import torch
+    return bool(os.environ.get('SAM2_MODEL'))
+
+
+def native_settings(o):
+    """Keyword arguments of the image_extender functions for options `o` (CLI args or ItemOptions)."""
+    return dict(canny_low=o.canny_low, canny_high=o.canny_high, kernel=o.kernel, dilate=o.dilate,
+                erode=o.erode, fast_morph=o.fast_morph, white_cyc=o.white_cyc, white_thr=o.white_thr,
+                min_area=o.min_area, feather=o.feather, invert=o.invert, working_size=o.working_size,
+                restrict_to_foreground=o.restrict_to_foreground)
+
+
+def finish_mask(scores, o, threshold=0.0):
+    """Model scores/logits -> final mask: > threshold, small components dropped, holes filled,
+    feathered and inverted like the app. Hand SAM2's raw output here."""
+    if native is not None:
+        return native.postprocess_mask(np.ascontiguousarray(scores), threshold=threshold, **native_settings(o))
+    return postprocess(np.where(scores > threshold, 255, 0).astype(np.uint8), o)
+
+
+def compute_mask(img, o):
+    """Heuristic mask with the same parameters as the C++ MaskSettings (the NumPy path at full resolution)."""
+    # TODO: Implement real SAM2 inference targeting 'vehicle' class and return finish_mask(logits, o).
+    # For now, reproduce the same heuristic/params as C++ for consistent results.
+    if native is not None:
+        return native.compute_vehicle_mask(img, **native_settings(o))
+    gray = cv2.cvtColor(img, cv2.COLOR_BGR2GRAY)
+    gray = cv2.medianBlur(gray, 5)
+    lo, hi = min(o.canny_low, o.canny_high), max(o.canny_low, o.canny_high)
+    edges = cv2.Canny(gray, lo, hi)
+    k = max(1, o.kernel | 1)
+    if o.fast_morph:
+        # Distance-transform equivalent of the iterated ellipse (see distanceMorph in vehicle_mask.cpp)
+        if o.dilate > 0:
+            dist = cv2.distanceTransform(cv2.bitwise_not(edges), cv2.DIST_L2, cv2.DIST_MASK_PRECISE)
+            edges = np.where(dist <= o.dilate * (k // 2) + 0.5, 255, 0).astype(np.uint8)
+        if o.erode > 0:
+            dist = cv2.distanceTransform(edges, cv2.DIST_L2, cv2.DIST_MASK_PRECISE)
+            edges = np.where(dist > o.erode * (k // 2) + 0.5, 255, 0).astype(np.uint8)
+    else:
+        ker = cv2.getStructuringElement(cv2.MORPH_ELLIPSE, (k, k))
+        if o.dilate > 0:
+            edges = cv2.dilate(edges, ker, iterations=o.dilate)
+        if o.erode > 0:
+            edges = cv2.erode(edges, ker, iterations=o.erode)
+    if o.white_cyc:
+        cx = img.shape[1] // 2
+        w = min(40, max(1, min(cx-1, img.shape[1]-cx-1)))
+        h = max(1, img.shape[0] // 10)
+        tR = (slice(0, h), slice(cx-w, cx+w+1))
+        bR = (slice(img.shape[0]-h, img.shape[0]), slice(cx-w, cx+w+1))
+        mt = np.mean(gray[tR])
+        mb = np.mean(gray[bR])
+        auto_thr = int(max(200, min(255, min(mt, mb) - 5)))
+        thr_use = o.white_thr if 0 <= o.white_thr <= 255 else auto_thr
+        non_white = (gray < thr_use).astype(np.uint8) * 255
+        edges = np.maximum(edges, non_white)
+    return postprocess((edges > 0).astype(np.uint8) * 255, o)
+
+
+def postprocess(mask, o):
+    """NumPy fallback of the C++ component filter, hole fill, feather and invert."""
+    if o.min_area > 0:
+        num, labels, stats, _ = cv2.connectedComponentsWithStats(mask, connectivity=8)
+        lut = np.where(stats[:, cv2.CC_STAT_AREA] >= o.min_area, 255, 0).astype(np.uint8)
+        lut[0] = 0
+        mask = lut[labels]
+    inv = cv2.bitwise_not(mask)
+    ff = np.zeros((inv.shape[0]+2, inv.shape[1]+2), dtype=np.uint8)
+    cv2.floodFill(inv, ff, (0,0), 0)
+    inv = cv2.bitwise_not(inv)
+    mask = cv2.bitwise_or(mask, inv)
+    if o.feather > 0:
+        rr = max(1, o.feather*2 + 1)
+        mask = cv2.GaussianBlur(mask, (rr, rr), 0)
+        _, mask = cv2.threshold(mask, 127, 255, cv2.THRESH_BINARY)
+    if o.invert:
+        mask = cv2.bitwise_not(mask)
+    return mask
+
+
+# ---- worker mode -------------------------------------------------------
+# Frames are a 4-byte little-endian length followed by UTF-8 text.
+
+def socket_reader(stdin):
+    """read(n, fds) over the app's socketpair, collecting descriptors passed with SCM_RIGHTS into
+    `fds`; None when stdin is not a socket (plain pipes work, without pixel handoff)."""
+    fd = os.dup(stdin.fileno())
+    try:
+        sock = socket.socket(fileno=fd)
+    except OSError:
+        os.close(fd)
+        return None
+
+    def read(n, fds):
+        data = b''
+        while len(data) < n:
+            chunk, anc, _, _ = sock.recvmsg(n - len(data), socket.CMSG_SPACE(4))
+            for level, kind, payload in anc:
+                if level == socket.SOL_SOCKET and kind == socket.SCM_RIGHTS:
+                    fds.extend(array.array('i', payload[:len(payload) - len(payload) % 4]))
+            if not chunk:
+                break
+            data += chunk
+        return data
+    return read
+
+
+def read_frame(read):
+    """(text, passed descriptors), or None at end of input."""
+    fds = []
+    head = read(4, fds)
+    if len(head) < 4:
+        return None
+    (n,) = struct.unpack('<I', head)
+    body = read(n, fds)
+    if len(body) < n:
+        return None
+    return body.decode('utf-8'), fds
+
+
+def write_frame(stream, text):
+    data = text.encode('utf-8')
+    stream.write(struct.pack('<I', len(data)) + data)
+    stream.flush()
+
+
+class ItemOptions:
+    """MaskSettings fields of a request line (tab separated), optionally preceded by in/out paths."""
+    def __init__(self, fields, paths=True):
+        if paths:
+            self.input, self.output = fields[0], fields[1]
+            fields = fields[2:]
+        (cl, ch, k, d, e, wc, wt, ma, fe, inv) = fields[:10]
+        self.fast_morph = len(fields) > 10 and fields[10] == '1'
+        self.working_size = int(fields[11]) if len(fields) > 11 else 0
+        self.restrict_to_foreground = len(fields) > 12 and fields[12] == '1'
+        self.canny_low, self.canny_high, self.kernel = int(cl), int(ch), int(k)
+        self.dilate, self.erode = int(d), int(e)
+        self.white_cyc, self.white_thr = wc == '1', int(wt)
+        self.min_area, self.feather, self.invert = int(ma), int(fe), inv == '1'
+
+
+def process_batch(items):
+    """Decode the whole batch first so a real model can run one inference call over it."""
+    results = []
+    imgs = [cv2.imread(it.input) for it in items]
+    for it, img in zip(items, imgs):
+        if img is None:
+            results.append('0 cannot read input')
+            continue
+        mask = compute_mask(img, it)
+        os.makedirs(os.path.dirname(it.output) or '.', exist_ok=True)
+        results.append('1' if cv2.imwrite(it.output, mask) else '0 cannot write output')
+    return results
+
+
+# ---- shared-memory pixel handoff --------------------------------------
+# The app passes an anonymous shared segment (memfd) over the socket once, copies
+# decoded BGR frames into it and reads the 8-bit masks back from the same place:
+# no codec or disk work here, and nothing named is left behind if either side dies.
+
+_segment = None
+
+
+def attach_segment(fds, size):
+    """Map the segment sent with `SEGMENT <id> <bytes>`, replacing the previous (smaller) one."""
+    global _segment
+    try:
+        if len(fds) != 1:
+            raise ValueError('SEGMENT needs exactly one descriptor, got %d' % len(fds))
+        if _segment is not None:
+            _segment.close()
+            _segment = None
+        _segment = mmap.mmap(fds[0], size)
+    finally:
+        for fd in fds:  # the mapping keeps the segment alive
+            os.close(fd)
+
+
+def process_buffers(lines):
+    """Each line: offset width height step mask_offset, then the MaskSettings fields."""
+    if _segment is None:
+        raise ValueError('no frame segment')
+    buf = _segment
+    items, imgs = [], []
+    for line in lines:
+        f = line.split('\t')
+        off, w, h, step, moff = (int(v) for v in f[:5])
+        items.append((ItemOptions(f[5:], paths=False), w, h, moff))
+        imgs.append(np.ndarray((h, w, 3), np.uint8, buffer=buf, offset=off, strides=(step, 3, 1)))
+    results = []
+    for (o, w, h, moff), img in zip(items, imgs):
+        out = np.ndarray((h, w), np.uint8, buffer=buf, offset=moff)
+        out[:] = compute_mask(img, o)
+        results.append('1')
+    return results  # views die with this frame, so the segment can be closed later
+
+
+def worker(allow_heuristic: bool) -> int:
+    stdin, stdout = sys.stdin.buffer, sys.stdout.buffer
+    # Anything printed by libraries must not corrupt the protocol stream
+    sys.stdout = sys.stderr
+    read = socket_reader(stdin)
+    caps = ' shm' if read is not None else ''
+    if read is None:
+        read = lambda n, fds: stdin.read(n)
+    if sam2_available():
+        write_frame(stdout, 'READY sam2' + caps)
+    elif allow_heuristic:
+        write_frame(stdout, 'READY heuristic' + caps)
+    else:
+        write_frame(stdout, 'UNAVAILABLE SAM2 not configured (set SAM2_MODEL)')
+        return 3
+    while True:
+        frame = read_frame(read)
+        if frame is None or frame[0].startswith('QUIT'):
+            return 0
+        req, fds = frame
+        lines = req.split('\n')
+        head = lines[0].split()
+        req_id, count = head[1], head[2]
+        if head[0] == 'SEGMENT':
+            try:
+                attach_segment(fds, int(count))
+                reply = 'OK %s 0' % req_id
+            except Exception as ex:  # anything but OK makes the app drop the segment
+                reply = 'FAILED %s %s' % (req_id, str(ex).replace('\n', ' '))
+            write_frame(stdout, reply)
+            continue
+        for fd in fds:  # only SEGMENT carries a descriptor
+            os.close(fd)
+        try:
+            if head[0] == 'MASKBUF':
+                results = process_buffers(lines[1:1 + int(count)])
+            else:
+                items = [ItemOptions(line.split('\t')) for line in lines[1:1 + int(count)]]
+                results = process_batch(items)
+        except Exception as ex:  # keep serving; report the whole batch as failed
+            results = ['0 ' + str(ex).replace('\n', ' ')] * int(count)
+        write_frame(stdout, '\n'.join(['OK %s %d' % (req_id, len(results))] + results))
+
+
 def main() -> int:
     p = argparse.ArgumentParser()
-    p.add_argument('--input', required=True)
-    p.add_argument('--output', required=True)
+    p.add_argument('--worker', action='store_true', default=False)
+    p.add_argument('--allow-heuristic', action='store_true', default=False)
+    p.add_argument('--input')
+    p.add_argument('--output')
     # Post-processing / heuristic args (kept in sync with C++ MaskSettings)
     p.add_argument('--canny-low', type=int, default=50)
     p.add_argument('--canny-high', type=int, default=150)
     p.add_argument('--kernel', type=int, default=7)
     p.add_argument('--dilate', type=int, default=2)
     p.add_argument('--erode', type=int, default=0)
+    p.add_argument('--fast-morph', action='store_true', default=False)
     p.add_argument('--white-cyc', action='store_true', default=False)
     p.add_argument('--white-thr', type=int, default=-1)
     p.add_argument('--min-area', type=int, default=5000)
     p.add_argument('--feather', type=int, default=0)
     p.add_argument('--invert', action='store_true', default=False)
+    p.add_argument('--working-size', type=int, default=0)
+    p.add_argument('--restrict-fg', dest='restrict_to_foreground', action='store_true', default=False)
     args = p.parse_args()
 
+    if args.worker:
+        return worker(args.allow_heuristic)
+    if not args.input or not args.output:
+        p.error('--input and --output are required')
+
     # Quick dependency check: allow graceful fallback upstream
     try:
-        # TODO: replace with actual SAM2 imports, e.g.:
-        # from sam2 import SamPredictor, sam2_model_from_cfg
-        # import torch
-        have_sam2 = bool(os.environ.get('SAM2_MODEL'))
+        have_sam2 = sam2_available()
     except Exception as e:
         print(f"SAM2 import error: {e}", file=sys.stderr)
         return 2
@@ -60,49 +332,7 @@ def main() -> int:
         print("Failed to read input image", file=sys.stderr)
         return 4
 
-    # TODO: Implement real SAM2 inference targeting 'vehicle' class.
-    # For now, reproduce the same heuristic/params as C++ for consistent results.
-    gray = cv2.cvtColor(img, cv2.COLOR_BGR2GRAY)
-    gray = cv2.medianBlur(gray, 5)
-    lo, hi = min(args.canny_low, args.canny_high), max(args.canny_low, args.canny_high)
-    edges = cv2.Canny(gray, lo, hi)
-    k = max(1, args.kernel | 1)
-    ker = cv2.getStructuringElement(cv2.MORPH_ELLIPSE, (k, k))
-    if args.dilate > 0:
-        edges = cv2.dilate(edges, ker, iterations=args.dilate)
-    if args.erode > 0:
-        edges = cv2.erode(edges, ker, iterations=args.erode)
-    if args.white_cyc:
-        cx = img.shape[1] // 2
-        w = min(40, max(1, min(cx-1, img.shape[1]-cx-1)))
-        h = max(1, img.shape[0] // 10)
-        tR = (slice(0, h), slice(cx-w, cx+w+1))
-        bR = (slice(img.shape[0]-h, img.shape[0]), slice(cx-w, cx+w+1))
-        mt = np.mean(gray[tR])
-        mb = np.mean(gray[bR])
-        auto_thr = int(max(200, min(255, min(mt, mb) - 5)))
-        thr_use = args.white_thr if 0 <= args.white_thr <= 255 else auto_thr
-        non_white = (gray < thr_use).astype(np.uint8) * 255
-        edges = np.maximum(edges, non_white)
-    mask = (edges > 0).astype(np.uint8) * 255
-    if args.min_area > 0:
-        num, labels, stats, _ = cv2.connectedComponentsWithStats(mask, connectivity=8)
-        keep = np.zeros(mask.shape, dtype=np.uint8)
-        for i in range(1, num):
-            if stats[i, cv2.CC_STAT_AREA] >= args.min_area:
-                keep[labels == i] = 255
-        mask = keep
-    inv = cv2.bitwise_not(mask)
-    ff = np.zeros((inv.shape[0]+2, inv.shape[1]+2), dtype=np.uint8)
-    cv2.floodFill(inv, ff, (0,0), 0)
-    inv = cv2.bitwise_not(inv)
-    mask = cv2.bitwise_or(mask, inv)
-    if args.feather > 0:
-        rr = max(1, args.feather*2 + 1)
-        mask = cv2.GaussianBlur(mask, (rr, rr), 0)
-        _, mask = cv2.threshold(mask, 127, 255, cv2.THRESH_BINARY)
-    if args.invert:
-        mask = cv2.bitwise_not(mask)
+    mask = compute_mask(img, args)
 
     os.makedirs(os.path.dirname(args.output) or '.', exist_ok=True)
     if not cv2.imwrite(args.output, mask):
@@ -0,0 +1,114 @@
+// Shared auto-fit implementation
+#include "auto_fit_vehicle.hpp"
+#include "vehicle_mask.hpp"
+#include "util/Resample.hpp"
+
+#include <opencv2/opencv.hpp>
+#include <filesystem>
+#include <iostream>
+#include <algorithm>
+#include <vector>
+
+using namespace cv;
+
+namespace
+{
+    inline std::string makeOutputPath(const std::filesystem::path &inPath)
+    {
+        return (inPath.parent_path() /
+                (inPath.stem().string() + "_autofit" + inPath.extension().string()))
+            .string();
+    }
+
+    static Mat makeStrip(const Mat &src, int newH, int W)
+    {
+        if (newH <= 0) return Mat();
+        if (!src.empty()) { Mat dst; resize(src, dst, Size(W, newH), 0, 0, INTER_AREA); return dst; }
+        return Mat(newH, W, CV_8UC3, Scalar(255, 255, 255));
+    }
+
+    // Bounding box of the largest 8-connected component; one labelling pass instead of
+    // tracing every contour and measuring its polygon area
+    static bool largestBlob(const Mat &mask, Rect &bbox)
+    {
+        Mat labels, stats, centroids;
+        const int n = connectedComponentsWithStats(mask, labels, stats, centroids, 8, CV_32S);
+        int best = 0, bestA = 0;
+        for (int i = 1; i < n; ++i)
+        {
+            const int a = stats.at<int>(i, CC_STAT_AREA);
+            if (a > bestA) { bestA = a; best = i; }
+        }
+        if (best == 0) return false;
+        bbox = Rect(stats.at<int>(best, CC_STAT_LEFT), stats.at<int>(best, CC_STAT_TOP),
+                    stats.at<int>(best, CC_STAT_WIDTH), stats.at<int>(best, CC_STAT_HEIGHT));
+        return true;
+    }
+}
+
+bool autoFitVehicle(const std::string &inPath, int canvasW, int canvasH,
+                    const ImageSettings &settings, const MaskSettings &mask)
+{
+    Mat img = imread(inPath);
+    if (img.empty()) { std::cerr << "[autoFitVehicle] cannot open: " << inPath << "\n"; return false; }
+    Mat vehicleMask;
+    if (!cachedVehicleMaskMat(inPath, img, vehicleMask, mask)) return false;
+    Mat out;
+    if (!autoFitVehicleMat(img, vehicleMask, out, canvasW, canvasH, settings))
+    {
+        std::cerr << "[autoFitVehicle] vehicle not found: " << inPath << "\n";
+        return false;
+    }
+    return imwrite(makeOutputPath(std::filesystem::path(inPath)), out);
+}
+
+bool autoFitVehicleMat(const cv::Mat &img, const cv::Mat &vehicleMask, cv::Mat &out,
+                       int canvasW, int canvasH, const ImageSettings &settings)
+{
+    if (img.empty() || vehicleMask.empty()) return false;
+    Rect bbox;
+    if (!largestBlob(vehicleMask, bbox)) return false;
+
+    if (canvasW <= 0) canvasW = img.cols;
+    if (canvasH <= 0) canvasH = img.rows;
+    int carW = std::max(1, bbox.width), carH = std::max(1, bbox.height);
+    double p = std::max(0.0, settings.padding);
+    double sx = double(canvasW) / (carW * (1.0 + 2.0 * p));
+    double sy = double(canvasH) / (carH * (1.0 + 2.0 * p));
+    double s = std::min(sx, sy); if (s <= 0.0) s = 1.0;
+    int scaledW = std::max(1, int(img.cols * s + 0.5));
+    int scaledH = std::max(1, int(img.rows * s + 0.5));
+    double cx = (bbox.x + bbox.width * 0.5) * s, cy = (bbox.y + bbox.height * 0.5) * s;
+    int offX = int(canvasW * 0.5 - cx + 0.5), offY = int(canvasH * 0.5 - cy + 0.5);
+
+    Mat canvas(canvasH, canvasW, img.type(), Scalar(255, 255, 255));
+    if (settings.stretchIfNeeded)
+    {
+        int topGap = std::max(0, offY);
+        int botGap = std::max(0, canvasH - (offY + scaledH));
+        Mat topSrc = (bbox.y > 0) ? img.rowRange(0, bbox.y) : Mat();
+        Mat botSrc = (bbox.y + bbox.height < img.rows) ? img.rowRange(bbox.y + bbox.height, img.rows) : Mat();
+        Mat topStrip = makeStrip(topSrc, topGap, canvasW);
+        Mat botStrip = makeStrip(botSrc, botGap, canvasW);
+        if (settings.blurRadius > 0)
+        {
+            int k = std::max(1, settings.blurRadius * 2 + 1);
+            if (!topStrip.empty()) GaussianBlur(topStrip, topStrip, Size(k, k), 0);
+            if (!botStrip.empty()) GaussianBlur(botStrip, botStrip, Size(k, k), 0);
+        }
+        if (!topStrip.empty()) topStrip.copyTo(canvas.rowRange(0, topStrip.rows));
+        if (!botStrip.empty()) botStrip.copyTo(canvas.rowRange(canvasH - botStrip.rows, canvasH));
+    }
+    // Only the part of the scaled frame that lands on the canvas is resampled
+    int x0 = std::max(0, offX), y0 = std::max(0, offY);
+    int x1 = std::min(canvasW, offX + scaledW), y1 = std::min(canvasH, offY + scaledH);
+    if (x1 > x0 && y1 > y0)
+    {
+        Rect dstR(x0, y0, x1 - x0, y1 - y0);
+        Rect srcR(x0 - offX, y0 - offY, dstR.width, dstR.height);
+        Mat visible; util::resampleRegion(img, visible, Size(scaledW, scaledH), srcR, INTER_LANCZOS4);
+        visible.copyTo(canvas(dstR));
+    }
+    out = canvas;
+    return true;
+}
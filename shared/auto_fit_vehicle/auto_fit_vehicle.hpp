@@ -0,0 +1,35 @@
+/*=======================  auto_fit_vehicle.hpp  =======================
+
+   Scale and centre the detected vehicle on a fixed-size canvas.
+   --------------------------------------------------------------------
+   • vehicle bbox from the largest connected component of the mask
+   • only the source region that lands on the canvas is resampled
+   • padding is a fraction of the vehicle size on every side
+   • optional stretched background above/below instead of white
+   • no OpenCV headers leak into dependers
+
+=====================================================================*/
+#pragma once
+#include <string>
+#include "models/ImageSettings.hpp"
+#include "models/MaskSettings.hpp"
+
+namespace cv { class Mat; }
+
+/**
+ * @brief Auto-fits the vehicle in `inPath` onto a canvasW x canvasH canvas and writes
+ *        `<stem>_autofit<ext>` next to the input. Uses settings.padding, stretchIfNeeded
+ *        and blurRadius; the mask is computed with `mask`.
+ * @return false if the image cannot be read, no vehicle is found or the write fails.
+ */
+bool autoFitVehicle(const std::string &inPath, int canvasW, int canvasH,
+                    const ImageSettings &settings, const MaskSettings &mask);
+
+/**
+ * @brief In-memory variant shared by the preview and every export path. `vehicleMask` is a CV_8U
+ *        mask for the same frame (e.g. from cachedVehicleMaskMat or FrameJob), so callers that
+ *        already have one do not recompute it. canvasW/canvasH <= 0 fall back to the source size.
+ * @return false if either input is empty or the mask has no foreground.
+ */
+bool autoFitVehicleMat(const cv::Mat &img, const cv::Mat &vehicleMask, cv::Mat &out,
+                       int canvasW, int canvasH, const ImageSettings &settings);
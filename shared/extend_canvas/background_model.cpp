@@ -0,0 +1,126 @@
+// Procedural background model for canvas-extension strips
+#include "background_model.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace bgmodel {
+
+BackgroundModel fitBackgroundModel(const cv::Mat& img, int y0, int y1, int maxDegree, int maxSamples)
+{
+    BackgroundModel model;
+    y0 = std::max(0, y0);
+    y1 = std::min(img.rows, y1);
+    const int band = y1 - y0;
+    if (img.empty() || img.type() != CV_8UC3 || band <= 0) return model;
+
+    const int n = std::min(band, std::max(1, maxSamples));
+    const int degree = std::clamp(maxDegree, 0, n - 1);
+    const int terms = degree + 1;
+    const int W = img.cols;
+
+    // Sample rows evenly across the band as flat float rows; t is the normalised row position
+    cv::Mat raw(n, W * 3, CV_32F);
+    cv::Mat design(n, terms, CV_32F);
+    for (int i = 0; i < n; ++i)
+    {
+        const int y = y0 + static_cast<int>((i + 0.5) * band / n);
+        cv::Mat dst = raw.row(i);
+        img.row(y).reshape(1, 1).convertTo(dst, CV_32F);
+        const float t = static_cast<float>((y + 0.5 - y0) / band);
+        float p = 1.0f;
+        for (int k = 0; k < terms; ++k) { design.at<float>(i, k) = p; p *= t; }
+    }
+
+    // Fit against horizontally smoothed samples so grain does not leak into the gradient
+    cv::Mat smooth;
+    const int kx = std::max(1, W / 128) | 1;
+    cv::blur(raw.reshape(3, n), smooth, cv::Size(kx, 1), cv::Point(-1, -1), cv::BORDER_REPLICATE);
+    smooth = smooth.reshape(1, n);
+
+    // Least squares for every column/channel at once: the design matrix is shared
+    cv::Mat pinv; cv::invert(design, pinv, cv::DECOMP_SVD);
+    cv::Mat coeffs; cv::gemm(pinv, smooth, 1.0, cv::Mat(), 0.0, coeffs);
+
+    // Noise level = residual of the raw samples against the fit
+    cv::Mat fitted; cv::gemm(design, coeffs, 1.0, cv::Mat(), 0.0, fitted);
+    cv::Mat resid = raw - fitted;
+    cv::Scalar mean, stddev;
+    cv::meanStdDev(resid.reshape(3, n), mean, stddev);
+
+    model.coeffs = coeffs.reshape(3, terms);
+    model.y0 = y0;
+    model.y1 = y1;
+    model.sigma = stddev;
+    return model;
+}
+
+BackgroundModel resizeModel(const BackgroundModel& model, int newWidth)
+{
+    if (!model.valid() || newWidth <= 0 || newWidth == model.width()) return model;
+    BackgroundModel out = model;
+    cv::resize(model.coeffs, out.coeffs, cv::Size(newWidth, model.coeffs.rows), 0, 0, cv::INTER_LINEAR);
+    return out;
+}
+
+cv::Mat synthesizeStrip(const BackgroundModel& model, int newH, bool grain, uint64 seed)
+{
+    if (newH <= 0 || !model.valid()) return cv::Mat();
+    const int W = model.width();
+    const int n = W * 3;
+    const int terms = model.coeffs.rows;
+    const bool addGrain = grain && (model.sigma[0] > 0.0 || model.sigma[1] > 0.0 || model.sigma[2] > 0.0);
+
+    cv::Mat out(newH, W, CV_8UC3);
+    cv::parallel_for_(cv::Range(0, newH), [&](const cv::Range& range)
+    {
+        std::vector<float> acc(n);
+        cv::Mat noise; if (addGrain) noise.create(1, W, CV_32FC3);
+        for (int y = range.start; y < range.end; ++y)
+        {
+            // Horner evaluation, one flat pass per term so the loops vectorise
+            const float t = static_cast<float>((y + 0.5) / newH);
+            const float* top = model.coeffs.ptr<float>(terms - 1);
+            std::copy(top, top + n, acc.begin());
+            for (int k = terms - 2; k >= 0; --k)
+            {
+                const float* c = model.coeffs.ptr<float>(k);
+                for (int i = 0; i < n; ++i) acc[i] = acc[i] * t + c[i];
+            }
+            if (addGrain)
+            {
+                // Seed per row so the output does not depend on how rows are split across threads
+                cv::RNG rng(seed + 0x9E3779B97F4A7C15ULL * static_cast<uint64>(y + 1));
+                rng.fill(noise, cv::RNG::NORMAL, cv::Scalar::all(0), model.sigma);
+                const float* nz = noise.ptr<float>();
+                for (int i = 0; i < n; ++i) acc[i] += nz[i];
+            }
+            uchar* dst = out.ptr<uchar>(y);
+            for (int i = 0; i < n; ++i) dst[i] = cv::saturate_cast<uchar>(acc[i]);
+        }
+    });
+    return out;
+}
+
+cv::Mat synthesizeBandStrip(const cv::Mat& img, int y0, int y1, int newH, int width, bool grain, uint64 seed)
+{
+    if (newH <= 0) return cv::Mat();
+    BackgroundModel model = fitBackgroundModel(img, y0, y1);
+    if (!model.valid()) return cv::Mat(newH, width, CV_8UC3, cv::Scalar(255, 255, 255));
+    return synthesizeStrip(resizeModel(model, width), newH, grain, seed);
+}
+
+cv::Mat synthesizeColumnStrip(const cv::Mat& img, int x0, int x1, int newW, bool grain, uint64 seed)
+{
+    if (newW <= 0) return cv::Mat();
+    x0 = std::max(0, x0);
+    x1 = std::min(img.cols, x1);
+    if (x1 <= x0) return cv::Mat(img.rows, newW, CV_8UC3, cv::Scalar(255, 255, 255));
+    // Transpose so the band's columns become rows and reuse the vertical fit
+    cv::Mat bandT; cv::transpose(img.colRange(x0, x1), bandT);
+    cv::Mat stripT = synthesizeBandStrip(bandT, 0, bandT.rows, newW, img.rows, grain, seed);
+    cv::Mat strip; cv::transpose(stripT, strip);
+    return strip;
+}
+
+}
@@ -0,0 +1,47 @@
+/*=======================  background_model.hpp  =======================
+
+   Procedural white-cyc background model used to synthesise extension
+   strips without stretching/blurring the source rows.
+   --------------------------------------------------------------------
+   • fits a per-column polynomial in y (per channel) to a background band
+   • measures the residual noise level so grain can be re-synthesised
+   • generates strips of any height in one row-parallel pass
+
+=====================================================================*/
+#pragma once
+#include <opencv2/opencv.hpp>
+
+namespace bgmodel {
+
+struct BackgroundModel
+{
+    cv::Mat coeffs;        // CV_32FC3, (degree + 1) rows x width cols; row k holds the t^k term
+    double y0 {0.0};       // source row range the model was fitted on (t = 0 .. 1)
+    double y1 {0.0};
+    cv::Scalar sigma;      // residual noise std-dev per channel (BGR)
+
+    bool valid() const { return !coeffs.empty(); }
+    int degree() const { return coeffs.rows - 1; }
+    int width() const { return coeffs.cols; }
+};
+
+// Fit a model to source rows [y0, y1) of a BGR 8-bit image. Up to maxSamples rows are sampled
+// evenly from the band; the polynomial degree is capped by maxDegree and by the sample count.
+// Returns an invalid model if the band is empty.
+BackgroundModel fitBackgroundModel(const cv::Mat& img, int y0, int y1, int maxDegree = 2, int maxSamples = 48);
+
+// Resample the model horizontally (coefficients are linear in x, so this is exact for the fit)
+BackgroundModel resizeModel(const BackgroundModel& model, int newWidth);
+
+// Generate a newH-row strip covering the model's source range; strip row r maps to the same
+// source row a vertical stretch would use. Grain adds the measured noise with a fixed seed.
+cv::Mat synthesizeStrip(const BackgroundModel& model, int newH, bool grain, uint64 seed = 0x5eedULL);
+
+// Convenience: fit rows [y0, y1) of img and synthesise a newH x width strip.
+// Falls back to a white strip when the band is empty (same as the stretch path).
+cv::Mat synthesizeBandStrip(const cv::Mat& img, int y0, int y1, int newH, int width, bool grain, uint64 seed = 0x5eedULL);
+
+// Horizontal counterpart: fit columns [x0, x1) of img and synthesise an img.rows x newW strip
+cv::Mat synthesizeColumnStrip(const cv::Mat& img, int x0, int x1, int newW, bool grain, uint64 seed = 0x5eedULL);
+
+}
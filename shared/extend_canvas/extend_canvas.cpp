@@ -1,11 +1,14 @@
 // Shared extend_canvas implementation
 #include "extend_canvas.hpp"
+#include "background_model.hpp"
 #include "util/ImageOps.hpp"
 
 #include <opencv2/opencv.hpp>
 #include <filesystem>
 #include <iostream>
 #include <algorithm>
+#include <cmath>
+#include <vector>
 
 using namespace cv;
 
@@ -29,18 +32,48 @@ namespace
         return Mat(newH, W, CV_8UC3, Scalar(255, 255, 255));
     }
 
-    static void blendVerticalSeam(Mat &img, int seamX, int overlap)
+    static Mat makeStripW(const Mat &src, int H, int newW)
     {
-        if (overlap <= 0) return;
+        if (newW <= 0) return Mat();
+        if (!src.empty()) { Mat dst; resize(src, dst, Size(newW, H), 0, 0, INTER_AREA); return dst; }
+        return Mat(H, newW, CV_8UC3, Scalar(255, 255, 255));
+    }
+
+    static void blurStrip(Mat &strip, int blurRadius)
+    {
+        if (blurRadius <= 0 || strip.empty()) return;
+        int k = std::max(1, blurRadius * 2 + 1);
+        GaussianBlur(strip, strip, Size(k, k), 0);
+    }
+
+    // Cross-fade `overlap` strip columns into the content they meet at seamX. Only the strip side is
+    // rewritten (the car is never touched): strip column i takes lerp(strip, content, a_i) with the
+    // paired content column on the other side of the seam. One row-parallel pass, no temporaries.
+    static void blendVerticalSeam(Mat &img, int seamX, int overlap, bool stripIsLeft)
+    {
+        if (overlap <= 0 || img.depth() != CV_8U) return;
         if (seamX - overlap < 0 || seamX + overlap > img.cols) return;
-        Mat left = img(Rect(seamX - overlap, 0, overlap, img.rows)).clone();
-        Mat right = img(Rect(seamX, 0, overlap, img.rows)).clone();
+        const int cn = img.channels();
+        const int n = overlap * cn;
+        const int stripX = (stripIsLeft ? seamX - overlap : seamX) * cn;
+        const int contentX = (stripIsLeft ? seamX : seamX - overlap) * cn;
+        std::vector<float> w(n);
         for (int i = 0; i < overlap; ++i)
         {
-            double a = (i + 1.0) / (overlap + 1.0);
-            Mat dstCol = img(Rect(seamX - overlap + i, 0, 1, img.rows));
-            addWeighted(right.col(i), a, left.col(i), 1.0 - a, 0.0, dstCol);
+            const float a = stripIsLeft ? (i + 1.0f) / (overlap + 1.0f) : float(overlap - i) / (overlap + 1.0f);
+            for (int c = 0; c < cn; ++c) w[i * cn + c] = a;
         }
+        parallel_for_(Range(0, img.rows), [&](const Range &r)
+        {
+            for (int y = r.start; y < r.end; ++y)
+            {
+                uchar *row = img.ptr<uchar>(y);
+                uchar *s = row + stripX;
+                const uchar *c = row + contentX;
+                for (int k = 0; k < n; ++k)
+                    s[k] = saturate_cast<uchar>(s[k] + (float(c[k]) - float(s[k])) * w[k]);
+            }
+        });
     }
 
     static Mat applyFinalResize(const Mat &canvas, int requestedW, int requestedH)
@@ -58,96 +91,289 @@ namespace
         resized.copyTo(finalCanvas(Rect(xOffset, yOffset, newWidth, newHeight)));
         return finalCanvas;
     }
-}
 
-bool extendCanvas(const std::string &inPath, int reqW, int reqH, int whiteThr,
-                  double padPct, int requestedW, int requestedH, int blurRadius)
-{
-    Mat img = imread(inPath);
-    if (img.empty()) { std::cerr << "[extendCanvas] cannot open: " << inPath << "\n"; return false; }
+    // 2-D extension: scale the padded car band (full source width) to fit inside the canvas, extend
+    // vertically with top/bottom strips, then extend horizontally with strips taken from the vertically
+    // extended column so the corners continue the top/bottom background.
+    static Mat extend2D(const Mat &img, int cropTop, int cropBot, int cropLeft, int cropRight,
+                        int desiredW, int desiredH, const ImageSettings &s)
+    {
+        const int W = img.cols;
+        const int carRows = cropBot - cropTop + 1;
+        const double scale = std::min(static_cast<double>(desiredW) / W, static_cast<double>(desiredH) / carRows);
+        const int cw = std::clamp(static_cast<int>(W * scale + 0.5), 1, desiredW);
+        const int ch = std::clamp(static_cast<int>(carRows * scale + 0.5), 1, desiredH);
+
+        Mat carReg = img.rowRange(cropTop, cropBot + 1);
+        Mat content = carReg;
+        if (cw != W || ch != carRows) resize(carReg, content, Size(cw, ch), 0, 0, INTER_LANCZOS4);
+
+        const int extraH = desiredH - ch;
+        const int topH = extraH / 2;
+        const int botH = extraH - topH;
+        Mat topStrip, botStrip;
+        if (s.proceduralBackground)
+        {
+            topStrip = bgmodel::synthesizeBandStrip(img, 0, cropTop, topH, cw, s.backgroundGrain, 1);
+            botStrip = bgmodel::synthesizeBandStrip(img, cropBot + 1, img.rows, botH, cw, s.backgroundGrain, 2);
+        }
+        else
+        {
+            topStrip = makeStrip(cropTop > 0 ? img.rowRange(0, cropTop) : Mat(), topH, cw);
+            botStrip = makeStrip(cropBot + 1 < img.rows ? img.rowRange(cropBot + 1, img.rows) : Mat(), botH, cw);
+            blurStrip(topStrip, s.blurRadius);
+            blurStrip(botStrip, s.blurRadius);
+        }
 
-    int actualWhiteThr = (whiteThr >= 0 && whiteThr <= 255) ? whiteThr : centerSampleThreshold(img);
+        Mat column(desiredH, cw, img.type());
+        int y = 0;
+        if (!topStrip.empty()) { topStrip.copyTo(column.rowRange(y, y + topStrip.rows)); y += topStrip.rows; }
+        content.copyTo(column.rowRange(y, y + content.rows)); y += content.rows;
+        if (!botStrip.empty()) { botStrip.copyTo(column.rowRange(y, y + botStrip.rows)); }
 
-    int fgTop, fgBot; if (!findForegroundBounds(img, fgTop, fgBot, actualWhiteThr)) return false;
-    int fgLeft, fgRight; if (!findForegroundBoundsX(img, fgLeft, fgRight, actualWhiteThr)) return false;
+        const int extraW = desiredW - cw;
+        if (extraW <= 0) return column;
+        const int leftW = extraW / 2;
+        const int rightW = extraW - leftW;
 
-    int carH = fgBot - fgTop + 1;
-    int pad = static_cast<int>(carH * padPct + 0.5);
-    int cropTop = std::max(0, fgTop - pad);
-    int cropBot = std::min(img.rows - 1, fgBot + pad);
-    Mat carReg = img.rowRange(cropTop, cropBot + 1);
+        // Background columns beside the car, in column (scaled) coordinates
+        const int sl = std::clamp(static_cast<int>(cropLeft * scale + 0.5), 0, cw);
+        const int sr = std::clamp(static_cast<int>((cropRight + 1) * scale + 0.5), sl, cw);
+        Mat leftStrip, rightStrip;
+        if (s.proceduralBackground)
+        {
+            leftStrip = bgmodel::synthesizeColumnStrip(column, 0, sl, leftW, s.backgroundGrain, 3);
+            rightStrip = bgmodel::synthesizeColumnStrip(column, sr, cw, rightW, s.backgroundGrain, 4);
+        }
+        else
+        {
+            leftStrip = makeStripW(sl > 0 ? column.colRange(0, sl) : Mat(), desiredH, leftW);
+            rightStrip = makeStripW(sr < cw ? column.colRange(sr, cw) : Mat(), desiredH, rightW);
+            blurStrip(leftStrip, s.blurRadius);
+            blurStrip(rightStrip, s.blurRadius);
+        }
 
-    int desiredH = (reqH > 0) ? reqH : img.rows;
-    int desiredW = (reqW > 0) ? reqW : img.cols;
-    int W = img.cols;
+        Mat wide(desiredH, desiredW, img.type());
+        int x = 0;
+        if (!leftStrip.empty()) { leftStrip.copyTo(wide(Rect(x, 0, leftStrip.cols, leftStrip.rows))); x += leftStrip.cols; }
+        column.copyTo(wide(Rect(x, 0, column.cols, column.rows))); x += column.cols;
+        if (!rightStrip.empty()) { rightStrip.copyTo(wide(Rect(x, 0, rightStrip.cols, rightStrip.rows))); }
 
-    if (desiredH <= carReg.rows)
+        const int seamOverlap = 24;
+        if (!leftStrip.empty()) { int seamX = leftStrip.cols; int ov = std::min({seamOverlap, leftStrip.cols, cw}); blendVerticalSeam(wide, seamX, ov, true); }
+        if (!rightStrip.empty()) { int seamX = wide.cols - rightStrip.cols; int ov = std::min({seamOverlap, rightStrip.cols, cw}); blendVerticalSeam(wide, seamX, ov, false); }
+        return wide;
+    }
+
+    // Canvas before the final resize. Detection is done by the caller so renditions can share it.
+    static Mat buildCanvas(const Mat &img, const ImageSettings &settings, const ExtendBounds &b)
     {
-        int yOff = (carReg.rows - desiredH) / 2;
-        Mat result = carReg.rowRange(yOff, yOff + desiredH);
-        if (desiredW != result.cols)
+        const int reqW = settings.width, reqH = settings.height;
+        const double padPct = settings.padding;
+        const int blurRadius = settings.blurRadius;
+        const int fgTop = b.top, fgBot = b.bot, fgLeft = b.left, fgRight = b.right;
+
+        int carH = fgBot - fgTop + 1;
+        int pad = static_cast<int>(carH * padPct + 0.5);
+        int cropTop = std::max(0, fgTop - pad);
+        int cropBot = std::min(img.rows - 1, fgBot + pad);
+        Mat carReg = img.rowRange(cropTop, cropBot + 1);
+
+        int desiredH = (reqH > 0) ? reqH : img.rows;
+        int desiredW = (reqW > 0) ? reqW : img.cols;
+        int W = img.cols;
+
+        if (settings.extendHorizontal)
         {
-            double scale = static_cast<double>(desiredW) / result.cols;
-            int scaledHeight = static_cast<int>(result.rows * scale + 0.5);
-            resize(result, result, Size(desiredW, scaledHeight), 0, 0, INTER_LANCZOS4);
-            if (scaledHeight > desiredH)
-            {
-                int yy = (scaledHeight - desiredH) / 2;
-                result = result.rowRange(yy, yy + desiredH);
-            }
-            else if (scaledHeight < desiredH)
+            int carW = fgRight - fgLeft + 1;
+            int padX = static_cast<int>(carW * padPct + 0.5);
+            int cropLeft = std::max(0, fgLeft - padX);
+            int cropRight = std::min(img.cols - 1, fgRight + padX);
+            return extend2D(img, cropTop, cropBot, cropLeft, cropRight, desiredW, desiredH, settings);
+        }
+
+        if (desiredH <= carReg.rows)
+        {
+            int yOff = (carReg.rows - desiredH) / 2;
+            Mat result = carReg.rowRange(yOff, yOff + desiredH);
+            if (desiredW != result.cols)
             {
-                Mat extended(desiredH, desiredW, result.type(), Scalar(255, 255, 255));
-                int yy = (desiredH - scaledHeight) / 2;
-                result.copyTo(extended.rowRange(yy, yy + scaledHeight));
-                result = extended;
+                double scale = static_cast<double>(desiredW) / result.cols;
+                int scaledHeight = static_cast<int>(result.rows * scale + 0.5);
+                resize(result, result, Size(desiredW, scaledHeight), 0, 0, INTER_LANCZOS4);
+                if (scaledHeight > desiredH)
+                {
+                    int yy = (scaledHeight - desiredH) / 2;
+                    result = result.rowRange(yy, yy + desiredH);
+                }
+                else if (scaledHeight < desiredH)
+                {
+                    Mat extended(desiredH, desiredW, result.type(), Scalar(255, 255, 255));
+                    int yy = (desiredH - scaledHeight) / 2;
+                    result.copyTo(extended.rowRange(yy, yy + scaledHeight));
+                    result = extended;
+                }
             }
+            return result;
         }
-        result = applyFinalResize(result, requestedW, requestedH);
-        const std::string outPath = makeOutputPath(std::filesystem::path(inPath));
-        return imwrite(outPath, result);
-    }
 
-    int extra = desiredH - carReg.rows;
-    int topH = extra / 2;
-    int botH = extra - topH;
+        int extra = desiredH - carReg.rows;
+        int topH = extra / 2;
+        int botH = extra - topH;
 
-    Mat scaledCarReg = carReg;
-    Mat scaledTopSrc, scaledBotSrc;
-    int targetW = W;
-    if (desiredW != W)
-    {
-        double scale = static_cast<double>(desiredW) / W;
-        int scaledCarHeight = static_cast<int>(carReg.rows * scale + 0.5);
-        resize(carReg, scaledCarReg, Size(desiredW, scaledCarHeight), 0, 0, INTER_LANCZOS4);
-        Mat topSrc = cropTop > 0 ? img.rowRange(0, cropTop) : Mat();
-        Mat botSrc = (cropBot + 1 < img.rows) ? img.rowRange(cropBot + 1, img.rows) : Mat();
-        if (!topSrc.empty()) { int h = static_cast<int>(topSrc.rows * scale + 0.5); resize(topSrc, scaledTopSrc, Size(desiredW, h), 0, 0, INTER_LANCZOS4); }
-        if (!botSrc.empty()) { int h = static_cast<int>(botSrc.rows * scale + 0.5); resize(botSrc, scaledBotSrc, Size(desiredW, h), 0, 0, INTER_LANCZOS4); }
-        extra = desiredH - scaledCarReg.rows; topH = extra / 2; botH = extra - topH; targetW = desiredW;
-    }
-    else
-    {
-        Mat topSrc = cropTop > 0 ? img.rowRange(0, cropTop) : Mat();
-        Mat botSrc = (cropBot + 1 < img.rows) ? img.rowRange(cropBot + 1, img.rows) : Mat();
-        scaledTopSrc = topSrc; scaledBotSrc = botSrc; targetW = W;
+        // Procedural strips are fitted on the unscaled bands, so the band rescale is only needed for stretching
+        const bool procedural = settings.proceduralBackground;
+        Mat scaledCarReg = carReg;
+        Mat scaledTopSrc, scaledBotSrc;
+        int targetW = W;
+        if (desiredW != W)
+        {
+            double scale = static_cast<double>(desiredW) / W;
+            int scaledCarHeight = static_cast<int>(carReg.rows * scale + 0.5);
+            resize(carReg, scaledCarReg, Size(desiredW, scaledCarHeight), 0, 0, INTER_LANCZOS4);
+            Mat topSrc = cropTop > 0 ? img.rowRange(0, cropTop) : Mat();
+            Mat botSrc = (cropBot + 1 < img.rows) ? img.rowRange(cropBot + 1, img.rows) : Mat();
+            if (!procedural && !topSrc.empty()) { int h = static_cast<int>(topSrc.rows * scale + 0.5); resize(topSrc, scaledTopSrc, Size(desiredW, h), 0, 0, INTER_LANCZOS4); }
+            if (!procedural && !botSrc.empty()) { int h = static_cast<int>(botSrc.rows * scale + 0.5); resize(botSrc, scaledBotSrc, Size(desiredW, h), 0, 0, INTER_LANCZOS4); }
+            extra = desiredH - scaledCarReg.rows; topH = extra / 2; botH = extra - topH; targetW = desiredW;
+        }
+        else
+        {
+            Mat topSrc = cropTop > 0 ? img.rowRange(0, cropTop) : Mat();
+            Mat botSrc = (cropBot + 1 < img.rows) ? img.rowRange(cropBot + 1, img.rows) : Mat();
+            scaledTopSrc = topSrc; scaledBotSrc = botSrc; targetW = W;
+        }
+
+        Mat topStrip, botStrip;
+        if (procedural)
+        {
+            // Model output is already smooth; blurRadius does not apply
+            topStrip = bgmodel::synthesizeBandStrip(img, 0, cropTop, topH, targetW, settings.backgroundGrain, 1);
+            botStrip = bgmodel::synthesizeBandStrip(img, cropBot + 1, img.rows, botH, targetW, settings.backgroundGrain, 2);
+        }
+        else
+        {
+            topStrip = makeStrip(scaledTopSrc, topH, targetW);
+            botStrip = makeStrip(scaledBotSrc, botH, targetW);
+            blurStrip(topStrip, blurRadius);
+            blurStrip(botStrip, blurRadius);
+        }
+
+        Mat canvas(desiredH, targetW, img.type());
+        int y = 0; if (!topStrip.empty()) { topStrip.copyTo(canvas.rowRange(y, y + topStrip.rows)); y += topStrip.rows; }
+        scaledCarReg.copyTo(canvas.rowRange(y, y + scaledCarReg.rows)); y += scaledCarReg.rows;
+        if (!botStrip.empty()) { botStrip.copyTo(canvas.rowRange(y, y + botStrip.rows)); }
+
+        return canvas;
     }
 
-    Mat topStrip = makeStrip(scaledTopSrc, topH, targetW);
-    Mat botStrip = makeStrip(scaledBotSrc, botH, targetW);
-    if (blurRadius > 0)
+    // Whether the canvas at a given size is the canvas at a larger size of the same aspect, scaled
+    // down: true for the 2-D and strip paths; the crop path (desiredH <= padded car band) is not,
+    // and a fixed blur radius does not scale with the output.
+    static bool isScaleInvariant(const Mat &img, const ImageSettings &settings, const ExtendBounds &b)
     {
-        int k = std::max(1, blurRadius * 2 + 1);
-        if (!topStrip.empty()) GaussianBlur(topStrip, topStrip, Size(k, k), 0);
-        if (!botStrip.empty()) GaussianBlur(botStrip, botStrip, Size(k, k), 0);
+        if (settings.blurRadius > 0 && !settings.proceduralBackground) return false;
+        if (settings.extendHorizontal) return true;
+        int carH = b.bot - b.top + 1;
+        int pad = static_cast<int>(carH * settings.padding + 0.5);
+        int bandRows = std::min(img.rows - 1, b.bot + pad) - std::max(0, b.top - pad) + 1;
+        int desiredH = (settings.height > 0) ? settings.height : img.rows;
+        return desiredH > bandRows;
     }
+}
 
-    Mat canvas(desiredH, targetW, img.type());
-    int y = 0; if (!topStrip.empty()) { topStrip.copyTo(canvas.rowRange(y, y + topStrip.rows)); y += topStrip.rows; }
-    scaledCarReg.copyTo(canvas.rowRange(y, y + scaledCarReg.rows)); y += scaledCarReg.rows;
-    if (!botStrip.empty()) { botStrip.copyTo(canvas.rowRange(y, y + botStrip.rows)); }
+bool extendCanvas(const std::string &inPath, int reqW, int reqH, int whiteThr,
+                  double padPct, int requestedW, int requestedH, int blurRadius)
+{
+    return extendCanvas(inPath, ImageSettings(reqW, reqH, whiteThr, padPct, blurRadius, requestedW, requestedH));
+}
 
-    canvas = applyFinalResize(canvas, requestedW, requestedH);
+bool extendCanvas(const std::string &inPath, const ImageSettings &settings)
+{
+    Mat img = imread(inPath);
+    if (img.empty()) { std::cerr << "[extendCanvas] cannot open: " << inPath << "\n"; return false; }
+    Mat result;
+    if (!extendCanvasMat(img, result, settings)) return false;
     const std::string outPath = makeOutputPath(std::filesystem::path(inPath));
-    return imwrite(outPath, canvas);
+    return imwrite(outPath, result);
+}
+
+bool detectExtendBounds(const cv::Mat &img, int whiteThr, ExtendBounds &bounds)
+{
+    if (img.empty()) return false;
+    bounds.whiteThr = (whiteThr >= 0 && whiteThr <= 255) ? whiteThr : centerSampleThreshold(img);
+    if (!findForegroundBounds(img, bounds.top, bounds.bot, bounds.whiteThr)) return false;
+    return findForegroundBoundsX(img, bounds.left, bounds.right, bounds.whiteThr);
+}
+
+bool extendCanvasMat(const cv::Mat &img, cv::Mat &out, const ImageSettings &settings)
+{
+    ExtendBounds bounds;
+    if (!detectExtendBounds(img, settings.whiteThreshold, bounds)) return false;
+    return extendCanvasMat(img, out, settings, bounds);
+}
+
+bool extendCanvasMat(const cv::Mat &img, cv::Mat &out, const ImageSettings &settings, const ExtendBounds &bounds)
+{
+    if (img.empty() || bounds.top < 0 || bounds.left < 0) return false;
+    out = applyFinalResize(buildCanvas(img, settings, bounds), settings.finalWidth, settings.finalHeight);
+    return true;
+}
+
+bool extendCanvasRenditions(const cv::Mat &img, const ImageSettings &base,
+                            const std::vector<Rendition> &renditions, std::vector<cv::Mat> &outs)
+{
+    ExtendBounds bounds;
+    if (!detectExtendBounds(img, base.whiteThreshold, bounds)) { outs.assign(renditions.size(), Mat()); return false; }
+    return extendCanvasRenditions(img, base, bounds, renditions, outs);
+}
+
+bool extendCanvasRenditions(const cv::Mat &img, const ImageSettings &base, const ExtendBounds &bounds,
+                            const std::vector<Rendition> &renditions, std::vector<cv::Mat> &outs)
+{
+    outs.assign(renditions.size(), Mat());
+    if (img.empty() || bounds.top < 0 || bounds.left < 0) return false;
+
+    // Largest canvases first so smaller same-aspect ones can be derived from them
+    std::vector<size_t> order(renditions.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    auto canvasSize = [&](const Rendition &r) {
+        return Size(r.width > 0 ? r.width : img.cols, r.height > 0 ? r.height : img.rows);
+    };
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return canvasSize(renditions[a]).area() > canvasSize(renditions[b]).area();
+    });
+
+    std::vector<Mat> derivable; // scale-invariant canvases rendered so far
+    for (size_t idx : order)
+    {
+        const Rendition &r = renditions[idx];
+        ImageSettings s = base;
+        s.width = r.width; s.height = r.height;
+        s.finalWidth = r.finalWidth; s.finalHeight = r.finalHeight;
+        const Size want = canvasSize(r);
+        const bool invariant = isScaleInvariant(img, s, bounds);
+
+        Mat canvas;
+        if (invariant)
+        {
+            for (const Mat &c : derivable)
+            {
+                // Same aspect to within a pixel, and at least as large
+                const bool sameAspect = std::abs(static_cast<double>(c.cols) * want.height - static_cast<double>(c.rows) * want.width)
+                                        <= std::max(c.cols, c.rows);
+                if (!sameAspect || c.cols < want.width || c.rows < want.height) continue;
+                if (c.size() == want) canvas = c;
+                else resize(c, canvas, want, 0, 0, INTER_AREA);
+                break;
+            }
+        }
+        if (canvas.empty())
+        {
+            canvas = buildCanvas(img, s, bounds);
+            if (invariant) derivable.push_back(canvas);
+        }
+        outs[idx] = applyFinalResize(canvas, r.finalWidth, r.finalHeight);
+    }
+    return true;
 }
@@ -4,11 +4,19 @@
    --------------------------------------------------------------------
    • declare `extendCanvas()` so any UI (wxWidgets, CLI, …) can call it
    • supports foreground detection, white threshold, padding, and resizing
+   • optional procedural background strips (see background_model.hpp)
+   • optional 2-D extension (side strips + corners) via ImageSettings
+   • rendition sets: many output sizes from one decode and one detection
    • no OpenCV headers leak into dependers
 
 =====================================================================*/
 #pragma once
 #include <string>
+#include <vector>
+#include "models/ImageSettings.hpp"
+#include "models/RenditionSet.hpp"
+
+namespace cv { class Mat; }
 
 /**
  * @brief Extends an image canvas using intelligent foreground detection and padding.
@@ -34,3 +42,47 @@ bool extendCanvas(const std::string &inPath,
                   int requestedH = -1,
                   int blurRadius = 0);
 
+
+/**
+ * @brief Same as above, driven by an ImageSettings (width/height, threshold, padding, blur,
+ *        final size and background synthesis options). Writes `<stem>_extended<ext>`.
+ */
+bool extendCanvas(const std::string &inPath, const ImageSettings &settings);
+
+/**
+ * @brief In-memory variant used by the previews and the CLI: extends `img` (BGR 8-bit) into `out`
+ *        without touching the filesystem. Returns false if no foreground is found.
+ */
+bool extendCanvasMat(const cv::Mat &img, cv::Mat &out, const ImageSettings &settings);
+
+/// Foreground detection result shared by every output generated from one frame
+struct ExtendBounds
+{
+    int whiteThr {-1};          // threshold actually used (auto-sampled when settings ask for -1)
+    int top {-1}, bot {-1};     // inclusive foreground rows
+    int left {-1}, right {-1};  // inclusive foreground columns
+};
+
+/**
+ * @brief Detects the non-white foreground once. `whiteThr` < 0 samples the cyc automatically.
+ * @return false if the frame has no foreground.
+ */
+bool detectExtendBounds(const cv::Mat &img, int whiteThr, ExtendBounds &bounds);
+
+/**
+ * @brief extendCanvasMat with precomputed bounds (settings.whiteThreshold is not consulted).
+ */
+bool extendCanvasMat(const cv::Mat &img, cv::Mat &out, const ImageSettings &settings, const ExtendBounds &bounds);
+
+/**
+ * @brief Generates every rendition of `img` with one detection pass. `base` supplies threshold,
+ *        padding and background options; each rendition supplies its canvas and final size.
+ *        Smaller renditions with the same aspect as an already rendered one are downscaled from it
+ *        when that gives the same framing. `outs` is index-aligned with `renditions`.
+ */
+bool extendCanvasRenditions(const cv::Mat &img, const ImageSettings &base,
+                            const std::vector<Rendition> &renditions, std::vector<cv::Mat> &outs);
+
+/// Same, with bounds already detected for this frame
+bool extendCanvasRenditions(const cv::Mat &img, const ImageSettings &base, const ExtendBounds &bounds,
+                            const std::vector<Rendition> &renditions, std::vector<cv::Mat> &outs);
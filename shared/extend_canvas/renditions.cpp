@@ -0,0 +1,177 @@
+// Rendition set parsing and output
+#include "renditions.hpp"
+#include "extend_canvas.hpp"
+
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+    struct Preset { const char *name; const char *spec; };
+
+    const Preset kPresets[] = {
+        { "ecommerce", "hero=1920x1080,square=1080x1080,portrait=1080x1350,thumb=480x270:jpg:85" },
+        { "social",    "story=1080x1920,square=1080x1080,portrait=1080x1350,landscape=1200x628" },
+    };
+
+    std::string trim(const std::string &s)
+    {
+        size_t a = s.find_first_not_of(" \t"), b = s.find_last_not_of(" \t");
+        return a == std::string::npos ? std::string() : s.substr(a, b - a + 1);
+    }
+
+    bool parseSize(const std::string &s, int &w, int &h)
+    {
+        char x = 0;
+        std::istringstream in(s);
+        if (!(in >> w >> x >> h) || (x != 'x' && x != 'X')) return false;
+        in >> std::ws;
+        return in.eof() && w >= 0 && h >= 0;
+    }
+
+    bool parseEntry(const std::string &entry, Rendition &r, std::string &err)
+    {
+        std::string body = entry;
+        const size_t eq = entry.find('=');
+        if (eq != std::string::npos) { r.name = trim(entry.substr(0, eq)); body = entry.substr(eq + 1); }
+
+        // size[>final][:format[:quality]]
+        std::string sizes = body, fmt, q;
+        const size_t c1 = body.find(':');
+        if (c1 != std::string::npos)
+        {
+            sizes = body.substr(0, c1);
+            fmt = body.substr(c1 + 1);
+            const size_t c2 = fmt.find(':');
+            if (c2 != std::string::npos) { q = fmt.substr(c2 + 1); fmt = fmt.substr(0, c2); }
+        }
+        std::string canvas = sizes, fin;
+        const size_t gt = sizes.find('>');
+        if (gt != std::string::npos) { canvas = sizes.substr(0, gt); fin = sizes.substr(gt + 1); }
+
+        if (!parseSize(trim(canvas), r.width, r.height)) { err = "bad size in '" + entry + "'"; return false; }
+        if (!fin.empty() && !parseSize(trim(fin), r.finalWidth, r.finalHeight)) { err = "bad final size in '" + entry + "'"; return false; }
+        r.format = trim(fmt);
+        std::transform(r.format.begin(), r.format.end(), r.format.begin(), [](unsigned char ch) { return static_cast<char>(std::tolower(ch)); });
+        if (!r.format.empty() && r.format[0] == '.') r.format.erase(0, 1);
+        if (!trim(q).empty())
+        {
+            try { r.quality = std::clamp(std::stoi(trim(q)), 1, 100); }
+            catch (...) { err = "bad quality in '" + entry + "'"; return false; }
+        }
+        if (r.name.empty()) r.name = std::to_string(r.width) + "x" + std::to_string(r.height);
+        return true;
+    }
+
+    std::string lower(std::string s)
+    {
+        std::transform(s.begin(), s.end(), s.begin(), [](unsigned char ch) { return static_cast<char>(std::tolower(ch)); });
+        return s;
+    }
+
+    bool sameOutput(const Rendition &a, const Rendition &b)
+    {
+        return a.width == b.width && a.height == b.height && a.finalWidth == b.finalWidth &&
+               a.finalHeight == b.finalHeight && a.format == b.format && a.quality == b.quality;
+    }
+
+    // Names become file suffixes: an exact repeat (e.g. "square" in both presets) is dropped,
+    // a different rendition under a taken name is an error rather than an overwrite.
+    bool addRendition(RenditionSet &set, const Rendition &r, std::string &err)
+    {
+        for (const Rendition &have : set.renditions)
+        {
+            if (lower(have.name) != lower(r.name)) continue;
+            if (have.name == r.name && sameOutput(have, r)) return true;
+            err = "duplicate rendition name '" + r.name + "'";
+            return false;
+        }
+        set.renditions.push_back(r);
+        return true;
+    }
+
+    std::vector<int> writeParams(const std::string &ext, int quality)
+    {
+        if (ext == "jpg" || ext == "jpeg") return { cv::IMWRITE_JPEG_QUALITY, quality };
+        if (ext == "webp") return { cv::IMWRITE_WEBP_QUALITY, quality };
+        return {};
+    }
+}
+
+bool parseRenditionSet(const std::string &spec, RenditionSet &set, std::string *error)
+{
+    set = RenditionSet();
+    std::string err;
+    std::string token;
+    std::string normalized = spec;
+    std::replace(normalized.begin(), normalized.end(), ';', ',');
+    std::istringstream in(normalized);
+    while (std::getline(in, token, ','))
+    {
+        token = trim(token);
+        if (token.empty()) continue;
+        const Preset *preset = nullptr;
+        for (const Preset &p : kPresets) if (token == p.name) preset = &p;
+        if (preset)
+        {
+            RenditionSet expanded;
+            parseRenditionSet(preset->spec, expanded);
+            for (const Rendition &r : expanded.renditions)
+                if (!addRendition(set, r, err)) { if (error) *error = err; set.renditions.clear(); return false; }
+            if (set.name.empty()) set.name = preset->name;
+            continue;
+        }
+        Rendition r;
+        if (!parseEntry(token, r, err) || !addRendition(set, r, err)) { if (error) *error = err; set.renditions.clear(); return false; }
+    }
+    if (set.name.empty() && !set.renditions.empty()) set.name = "custom";
+    return true;
+}
+
+std::vector<std::string> renditionPresetNames()
+{
+    std::vector<std::string> names;
+    for (const Preset &p : kPresets) names.push_back(p.name);
+    return names;
+}
+
+std::string renditionOutputPath(const std::string &outBase, const Rendition &r)
+{
+    const std::filesystem::path base(outBase);
+    std::string ext = r.format.empty() ? base.extension().string() : "." + r.format;
+    return (base.parent_path() / (base.stem().string() + "_" + r.name + ext)).string();
+}
+
+int writeRenditions(const std::string &inPath, const ImageSettings &base,
+                    const RenditionSet &set, const std::string &outBase)
+{
+    cv::Mat img = cv::imread(inPath);
+    if (img.empty()) { std::cerr << "[writeRenditions] cannot open: " << inPath << "\n"; return 0; }
+    return writeRenditions(img, base, set, outBase);
+}
+
+int writeRenditions(const cv::Mat &img, const ImageSettings &base, const RenditionSet &set,
+                    const std::string &outBase, const ExtendBounds *bounds)
+{
+    std::vector<cv::Mat> outs;
+    const bool found = bounds ? extendCanvasRenditions(img, base, *bounds, set.renditions, outs)
+                              : extendCanvasRenditions(img, base, set.renditions, outs);
+    if (!found) { std::cerr << "[writeRenditions] foreground not found: " << outBase << "\n"; return 0; }
+
+    int written = 0;
+    for (size_t i = 0; i < outs.size(); ++i)
+    {
+        const Rendition &r = set.renditions[i];
+        const std::string path = renditionOutputPath(outBase, r);
+        std::string ext = std::filesystem::path(path).extension().string();
+        if (!ext.empty()) ext.erase(0, 1);
+        std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char ch) { return static_cast<char>(std::tolower(ch)); });
+        if (cv::imwrite(path, outs[i], writeParams(ext, r.quality))) ++written;
+        else std::cerr << "[writeRenditions] cannot write: " << path << "\n";
+    }
+    return written;
+}
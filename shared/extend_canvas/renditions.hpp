@@ -0,0 +1,41 @@
+/*==========================  renditions.hpp  ==========================
+
+   Rendition sets for the batch and CLI front ends.
+   --------------------------------------------------------------------
+   • parse a spec string or preset name into a RenditionSet
+   • write every rendition of one input from a single decode
+
+   Spec grammar (entries separated by ',' or ';'):
+       name=WxH[>FWxFH][:format[:quality]]
+   e.g.  "hero=1920x1080,square=1080x1080:jpg:90,thumb=480x270:webp:80"
+   A bare preset name ("ecommerce", "social") expands to its entries.
+   Exact repeats are dropped; two different entries under one name fail.
+
+=====================================================================*/
+#pragma once
+#include <string>
+#include <vector>
+#include "models/ImageSettings.hpp"
+#include "models/RenditionSet.hpp"
+
+namespace cv { class Mat; }
+struct ExtendBounds;
+
+bool parseRenditionSet(const std::string &spec, RenditionSet &set, std::string *error = nullptr);
+
+std::vector<std::string> renditionPresetNames();
+
+// <dir of outBase>/<stem of outBase>_<name>.<format or ext of outBase>
+std::string renditionOutputPath(const std::string &outBase, const Rendition &r);
+
+/**
+ * @brief Decodes `inPath` once and writes every rendition of `set` next to `outBase`
+ *        (see renditionOutputPath). Returns the number of files written; 0 on decode or
+ *        detection failure.
+ */
+int writeRenditions(const std::string &inPath, const ImageSettings &base,
+                    const RenditionSet &set, const std::string &outBase);
+
+/// Same for an already decoded frame; pass `bounds` when detection was done by the caller.
+int writeRenditions(const cv::Mat &img, const ImageSettings &base, const RenditionSet &set,
+                    const std::string &outBase, const ExtendBounds *bounds = nullptr);
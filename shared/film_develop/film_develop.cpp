@@ -0,0 +1,558 @@
+// Shared film develop engine
+#include "film_develop.hpp"
+#include "film_grain.hpp"
+#include "util/Blend.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <list>
+#include <map>
+#include <mutex>
+#include <random>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+using namespace cv;
+
+namespace
+{
+    // Mean over bright pixels is clearly blue: the file was most likely stored RGB(A)
+    bool isBlueDominant(const Mat& bgr)
+    {
+        if (bgr.empty()) return false;
+        Mat gray; cvtColor(bgr, gray, COLOR_BGR2GRAY);
+        // Mask of bright pixels (avoid dark background bias)
+        Mat mask; threshold(gray, mask, 32, 255, THRESH_BINARY);
+        if (countNonZero(mask) < (bgr.rows * bgr.cols) / 200) return false; // not enough signal
+        Scalar m = mean(bgr, mask);
+        double mb = m[0], mg = m[1], mr = m[2];
+        return mb > 1.3 * std::max(1e-6, mr) && mb > 1.3 * std::max(1e-6, mg);
+    }
+
+    Mat swapRB(const Mat& bgr)
+    {
+        std::vector<Mat> ch; split(bgr, ch); std::swap(ch[0], ch[2]);
+        Mat out; merge(ch, out);
+        return out;
+    }
+
+    // Colour and alpha planes of a decoded texture per useTextureLuminance
+    void splitTexture(const Mat& tex, const DevelopSettings& settings, Mat& texBGR, Mat& alpha)
+    {
+        switch (tex.channels())
+        {
+        case 4:
+        {
+            cvtColor(tex, texBGR, COLOR_BGRA2BGR);
+            Mat a; extractChannel(tex, a, 3);
+            if (settings.useTextureLuminance)
+            {
+                // Luminance as alpha, colour neutralised to gray, original transparency kept
+                Mat gray; cvtColor(texBGR, gray, COLOR_BGR2GRAY);
+                const double invMaxTex = (texBGR.depth() == CV_16U) ? (1.0/65535.0) : (1.0/255.0);
+                multiply(gray, a, alpha, invMaxTex);
+                texBGR = Mat(); cvtColor(gray, texBGR, COLOR_GRAY2BGR);
+            }
+            else
+            {
+                alpha = a;
+            }
+            break;
+        }
+        case 3:
+        {
+            texBGR = tex;
+            if (settings.useTextureLuminance)
+            {
+                // Alpha from luminance, colour cast removed for neutral blending
+                Mat gray; cvtColor(texBGR, gray, COLOR_BGR2GRAY);
+                alpha = gray;
+                texBGR = Mat(); cvtColor(gray, texBGR, COLOR_GRAY2BGR);
+            }
+            break;
+        }
+        case 1:
+        default:
+        {
+            // Single channel: the channel is the alpha when requested; gray colour for blending
+            if (settings.useTextureLuminance) alpha = tex;
+            cvtColor(tex, texBGR, COLOR_GRAY2BGR);
+            break;
+        }
+        }
+    }
+
+    // Black-background JPG textures with a colour cast: worth neutralising when luminance is not requested
+    bool tintedOnBlack(const Mat& texBGR)
+    {
+        Mat gray; cvtColor(texBGR, gray, COLOR_BGR2GRAY);
+        Mat bgMask; threshold(gray, bgMask, 16, 255, THRESH_BINARY_INV);
+        double bgRatio = double(countNonZero(bgMask)) / double(texBGR.rows * texBGR.cols);
+        Mat fgMask; threshold(gray, fgMask, 32, 255, THRESH_BINARY);
+        int fgCount = countNonZero(fgMask);
+        if (fgCount <= (texBGR.rows * texBGR.cols) / 200) return false;
+        Scalar m = mean(texBGR, fgMask);
+        double mb = m[0], mg = m[1], mr = m[2];
+        double spread = std::max({ std::abs(mb - mr), std::abs(mb - mg), std::abs(mg - mr) });
+        return bgRatio > 0.4 && spread > 5.0;
+    }
+
+    DevelopTextureFlags decideFlags(const Mat& texBGR, const DevelopSettings& settings)
+    {
+        DevelopTextureFlags f;
+        // RGBA/BGR auto-fix, taken only if the swapped reading is not blue-dominant as well
+        f.swapRB = settings.swapRB || (isBlueDominant(texBGR) && !isBlueDominant(swapRB(texBGR)));
+        f.neutralise = !settings.useTextureLuminance && tintedOnBlack(f.swapRB ? swapRB(texBGR) : texBGR);
+        return f;
+    }
+
+    // Flags per (path, file size, mtime, luminance, swapRB, export width, export height), decided on the
+    // texture as the export prepares it, so a preview proxy gets the export's colour treatment
+    using FlagsKey = std::tuple<std::string, uintmax_t, long long, bool, bool, int, int>;
+
+    std::mutex g_flagsMutex;
+    std::map<FlagsKey, DevelopTextureFlags> g_flags;
+
+    bool knownFlags(const FlagsKey& key, DevelopTextureFlags& flags)
+    {
+        std::lock_guard<std::mutex> lock(g_flagsMutex);
+        auto it = g_flags.find(key);
+        if (it == g_flags.end()) return false;
+        flags = it->second;
+        return true;
+    }
+
+    void rememberFlags(const FlagsKey& key, const DevelopTextureFlags& flags)
+    {
+        std::lock_guard<std::mutex> lock(g_flagsMutex);
+        g_flags[key] = flags;
+    }
+
+    using TexturePtr = std::shared_ptr<const DevelopTexture>;
+    // path, file size, mtime, width, height, interpolation, luminance, swapRB, export width, export height
+    using TextureKey = std::tuple<std::string, uintmax_t, long long, int, int, int, bool, bool, int, int>;
+
+    class TextureCache
+    {
+    public:
+        static size_t budget()
+        {
+            static const size_t bytes = []
+            {
+                const char* v = std::getenv("DEVELOP_TEXTURE_CACHE_MB");
+                const long long mb = v ? std::atoll(v) : 2048;
+                return static_cast<size_t>(std::max(0LL, mb)) << 20;
+            }();
+            return bytes;
+        }
+
+        // `produce` fills the texture on a miss; false = unreadable, nothing is cached
+        TexturePtr get(const TextureKey& key, const std::function<bool(DevelopTexture&)>& produce)
+        {
+            std::shared_future<TexturePtr> pending;
+            std::promise<TexturePtr> promise;
+            uint64_t serial = 0;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                auto it = entries_.find(key);
+                if (it != entries_.end())
+                {
+                    lru_.splice(lru_.begin(), lru_, it->second.pos);
+                    pending = it->second.value;
+                }
+                else
+                {
+                    lru_.push_front(key);
+                    pending = promise.get_future().share();
+                    serial = ++serial_;
+                    entries_.emplace(key, Entry{ pending, 0, serial, lru_.begin() });
+                }
+            }
+            if (serial == 0) return pending.get();
+
+            // First request for this key: prepare outside the lock while other callers wait on the future
+            TexturePtr result;
+            try
+            {
+                auto prepared = std::make_shared<DevelopTexture>();
+                if (produce(*prepared)) result = prepared;
+            }
+            catch (...) {} // bad_alloc, filesystem_error...: waiters must still be released, and the entry dropped
+            promise.set_value(result);
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = entries_.find(key);
+            if (it == entries_.end() || it->second.serial != serial) return result; // cleared meanwhile
+            if (!result) { lru_.erase(it->second.pos); entries_.erase(it); return result; }
+            it->second.bytes = bytesOf(*result);
+            used_ += it->second.bytes;
+            evict();
+            return result;
+        }
+
+        void clear()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            entries_.clear();
+            lru_.clear();
+            used_ = 0;
+        }
+
+    private:
+        struct Entry
+        {
+            std::shared_future<TexturePtr> value;
+            size_t bytes;  // 0 while being prepared
+            uint64_t serial;
+            std::list<TextureKey>::iterator pos;
+        };
+
+        static size_t bytesOf(const DevelopTexture& t)
+        {
+            return t.bgr.total() * t.bgr.elemSize() + t.alpha.total() * t.alpha.elemSize();
+        }
+
+        // Least recently used ready entries first; the newest stays even if it alone exceeds the budget
+        void evict()
+        {
+            auto it = lru_.end();
+            while (used_ > budget() && it != lru_.begin())
+            {
+                --it;
+                if (it == lru_.begin()) break;
+                auto e = entries_.find(*it);
+                if (e->second.bytes == 0) continue; // still being prepared
+                used_ -= e->second.bytes;
+                entries_.erase(e);
+                it = lru_.erase(it);
+            }
+        }
+
+        std::mutex mutex_;
+        std::map<TextureKey, Entry> entries_;
+        std::list<TextureKey> lru_; // most recently used first
+        size_t used_ {0};
+        uint64_t serial_ {0};
+    };
+
+    TextureCache& textureCache()
+    {
+        static TextureCache cache;
+        return cache;
+    }
+
+    uint64_t splitmix64(uint64_t x)
+    {
+        x += 0x9e3779b97f4a7c15ULL;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+
+    const char* const kManifestHeader = "output\tinput\tvariant\tseed\ttexture\tblend_mode\topacity\tluminance\tswap_rb";
+}
+
+bool loadDevelopTexture(const std::string& path, cv::Mat& tex)
+{
+    Mat t = imread(path, IMREAD_UNCHANGED);
+    if (t.empty()) return false;
+    // The blend kernel takes 8/16-bit textures; float (EXR/HDR) ones are brought to 8-bit
+    if (t.depth() != CV_8U && t.depth() != CV_16U) t.convertTo(t, CV_8U, (t.depth() == CV_32F || t.depth() == CV_64F) ? 255.0 : 1.0);
+    tex = t;
+    return true;
+}
+
+DevelopTextureFlags analyseDevelopTexture(const cv::Mat& tex, const DevelopSettings& settings)
+{
+    if (tex.empty()) return DevelopTextureFlags();
+    Mat texBGR, alpha;
+    splitTexture(tex, settings, texBGR, alpha);
+    return decideFlags(texBGR, settings);
+}
+
+bool prepareDevelopTexture(const cv::Mat& texIn, cv::Size size, const DevelopSettings& settings,
+                           DevelopTexture& out, int interpolation, const DevelopTextureFlags* flags)
+{
+    if (texIn.empty() || size.width <= 0 || size.height <= 0) return false;
+    Mat tex = texIn;
+    if (tex.size() != size) resize(texIn, tex, size, 0, 0, interpolation);
+
+    // Keep blending in BGR (OpenCV native). New Mats throughout so a caller's texture is never written.
+    Mat texBGR, alpha;
+    splitTexture(tex, settings, texBGR, alpha);
+    const DevelopTextureFlags f = flags ? *flags : decideFlags(texBGR, settings);
+    if (f.swapRB) texBGR = swapRB(texBGR);
+    if (f.neutralise)
+    {
+        // Bright content is the signal: luminance becomes alpha and colour is neutralised
+        Mat gray; cvtColor(texBGR, gray, COLOR_BGR2GRAY);
+        alpha = gray;
+        texBGR = Mat(); cvtColor(gray, texBGR, COLOR_GRAY2BGR);
+    }
+
+    out.bgr = texBGR;
+    out.alpha = alpha;
+    return true;
+}
+
+void developBlend(const cv::Mat& base, const DevelopTexture& tex, const DevelopSettings& settings, cv::Mat& out)
+{
+    util::blendTexture(base, tex.bgr, tex.alpha, out, settings.blendMode, settings.opacity);
+}
+
+std::shared_ptr<const DevelopTexture> cachedDevelopTexture(const std::string& path, cv::Size size,
+                                                           const DevelopSettings& settings, int interpolation,
+                                                           cv::Size exportSize)
+{
+    namespace fs = std::filesystem;
+    std::function<bool(DevelopTexture&)> produce;
+    TextureKey key;
+    GrainSettings grain;
+    if (parseGrainSpec(path, grain))
+    {
+        // Synthesised at the target size: no file, no filter, and the texture flags do not apply
+        if (size.width <= 0 || size.height <= 0) return nullptr;
+        produce = [grain, size](DevelopTexture& t) { synthesizeGrainTexture(grain, size, t); return true; };
+        key = TextureKey(grainSpec(grain), 0, 0, size.width, size.height, 0, false, false, 0, 0);
+    }
+    else
+    {
+        std::error_code ec;
+        const uintmax_t bytes = fs::file_size(path, ec);
+        if (ec) return nullptr;
+        const auto mtime = fs::last_write_time(path, ec).time_since_epoch().count();
+        if (ec) return nullptr;
+        const cv::Size decideAt = exportSize.width > 0 && exportSize.height > 0 ? exportSize : size;
+        const FlagsKey flagsKey(path, bytes, static_cast<long long>(mtime), settings.useTextureLuminance, settings.swapRB,
+                                decideAt.width, decideAt.height);
+        produce = [&path, flagsKey, size, decideAt, settings, interpolation](DevelopTexture& t)
+        {
+            Mat tex;
+            if (!loadDevelopTexture(path, tex)) return false;
+            DevelopTextureFlags flags;
+            if (!knownFlags(flagsKey, flags))
+            {
+                // Decided on the texture Lanczos-resized to the export size, exactly as the export prepares it
+                Mat sized = tex;
+                if (tex.size() != decideAt) resize(tex, sized, decideAt, 0, 0, INTER_LANCZOS4);
+                flags = analyseDevelopTexture(sized, settings);
+                rememberFlags(flagsKey, flags);
+                if (size == decideAt && interpolation == INTER_LANCZOS4) tex = sized; // the export: resized once
+            }
+            return prepareDevelopTexture(tex, size, settings, t, interpolation, &flags);
+        };
+        key = TextureKey(path, bytes, static_cast<long long>(mtime), size.width, size.height, interpolation,
+                         settings.useTextureLuminance, settings.swapRB, decideAt.width, decideAt.height);
+    }
+
+    if (TextureCache::budget() == 0)
+    {
+        auto prepared = std::make_shared<DevelopTexture>();
+        if (!produce(*prepared)) return nullptr;
+        return prepared;
+    }
+    return textureCache().get(key, produce);
+}
+
+void clearDevelopTextureCache()
+{
+    textureCache().clear();
+    std::lock_guard<std::mutex> lock(g_flagsMutex);
+    g_flags.clear();
+}
+
+bool developImage(const cv::Mat& base, const cv::Mat& tex, const DevelopSettings& settings, cv::Mat& out)
+{
+    if (base.empty()) return false;
+    DevelopTexture prepared;
+    if (!prepareDevelopTexture(tex, base.size(), settings, prepared)) return false;
+    developBlend(base, prepared, settings, out);
+    return true;
+}
+
+uint64_t developVariantSeed(uint64_t batchSeed, const std::string& imageName, int k)
+{
+    uint64_t h = 0xcbf29ce484222325ULL; // FNV-1a
+    for (unsigned char c : imageName) { h ^= c; h *= 0x100000001b3ULL; }
+    return splitmix64(splitmix64(batchSeed ^ h) + static_cast<uint64_t>(k));
+}
+
+void pickDevelopVariant(uint64_t seed, size_t textureCount, const DevelopSettings& base,
+                        int& texture, DevelopSettings& out)
+{
+    // mt19937_64's sequence is fixed by the standard; distributions are not, hence the plain modulo
+    std::mt19937_64 rng(seed);
+    texture = textureCount ? static_cast<int>(rng() % textureCount) : 0;
+    out = base;
+    out.blendMode = static_cast<int>(rng() % 3);
+    out.opacity = float(30 + rng() % 51) / 100.0f; // same range as the UI's randomiser
+}
+
+std::vector<DevelopManifestRow> planDevelopBatch(const std::vector<std::string>& images,
+                                                 const std::vector<std::string>& textures,
+                                                 const DevelopBatchOptions& options)
+{
+    namespace fs = std::filesystem;
+    std::vector<DevelopManifestRow> rows;
+    if (textures.empty()) return rows;
+    const int variants = std::max(1, options.variants);
+    // Output paths handed out so far, lower-cased since case-insensitive file systems collide too
+    std::set<std::string> taken;
+    auto lower = [](std::string v) { std::transform(v.begin(), v.end(), v.begin(), [](unsigned char c){ return char(std::tolower(c)); }); return v; };
+    for (const auto& image : images)
+    {
+        const fs::path in(image);
+        auto outputOf = [&](const std::string& stem, int k)
+        {
+            std::string name = stem + "_developed";
+            if (variants > 1) name += "_" + std::to_string(k);
+            return (fs::path(options.outDir) / (name + in.extension().string())).string();
+        };
+        // Same-named inputs from different folders become <stem>_2, <stem>_3...: one writer per
+        // output, and their own seeds
+        std::string stem = in.stem().string();
+        for (int dup = 2;; ++dup)
+        {
+            bool unused = true;
+            for (int k = 1; k <= variants && unused; ++k) unused = !taken.count(lower(outputOf(stem, k)));
+            if (unused) break;
+            stem = in.stem().string() + "_" + std::to_string(dup);
+        }
+        const std::string seedName = stem + in.extension().string();
+        for (int k = 1; k <= variants; ++k)
+        {
+            DevelopManifestRow r;
+            r.input = image;
+            r.variant = k;
+            r.output = outputOf(stem, k);
+            taken.insert(lower(r.output));
+            int texture = 0;
+            r.settings = options.settings;
+            if (options.randomize)
+            {
+                r.seed = developVariantSeed(options.seed, seedName, k);
+                pickDevelopVariant(r.seed, textures.size(), options.settings, texture, r.settings);
+            }
+            r.texture = textures[texture];
+            // Unseeded procedural textures take the row's seed, so every variant gets its own grain
+            GrainSettings grain;
+            bool seeded = true;
+            if (options.randomize && parseGrainSpec(r.texture, grain, &seeded) && !seeded)
+            {
+                grain.seed = r.seed;
+                r.texture = grainSpec(grain);
+            }
+            rows.push_back(r);
+        }
+    }
+    return rows;
+}
+
+int runDevelopRows(const std::vector<DevelopManifestRow>& rows, std::vector<bool>* ok)
+{
+    // Rows grouped by input, in order of first appearance
+    std::vector<std::vector<size_t>> groups;
+    std::map<std::string, size_t> groupOf;
+    for (size_t i = 0; i < rows.size(); ++i)
+    {
+        auto it = groupOf.emplace(rows[i].input, groups.size()).first;
+        if (it->second == groups.size()) groups.emplace_back();
+        groups[it->second].push_back(i);
+    }
+
+    std::vector<char> done(rows.size(), 0); // not vector<bool>: rows finish on different threads
+    std::mutex logMutex;
+    auto fail = [&](const std::string& msg)
+    {
+        std::lock_guard<std::mutex> lock(logMutex);
+        std::cerr << "[runDevelopRows] " << msg << "\n";
+    };
+    // One image per stripe; the blend inside runs serially on the worker
+    parallel_for_(Range(0, static_cast<int>(groups.size())), [&](const Range& range)
+    {
+        for (int g = range.start; g < range.end; ++g)
+        {
+            const auto& group = groups[g];
+            Mat base = imread(rows[group.front()].input, IMREAD_COLOR);
+            if (base.empty()) { fail("cannot open: " + rows[group.front()].input); continue; }
+            for (size_t i : group)
+            {
+                const DevelopManifestRow& r = rows[i];
+                auto texture = cachedDevelopTexture(r.texture, base.size(), r.settings);
+                if (!texture) { fail("cannot load texture: " + r.texture); continue; }
+                Mat result;
+                developBlend(base, *texture, r.settings, result);
+                bool written = false;
+                try { written = imwrite(r.output, result); } catch (const cv::Exception&) {}
+                if (written) done[i] = 1;
+                else fail("cannot write: " + r.output);
+            }
+        }
+    }, static_cast<double>(groups.size()));
+
+    if (ok) ok->assign(done.begin(), done.end());
+    return static_cast<int>(std::count(done.begin(), done.end(), 1));
+}
+
+bool writeDevelopManifest(const std::string& path, const std::vector<DevelopManifestRow>& rows)
+{
+    std::ofstream out(path, std::ios::trunc);
+    if (!out) return false;
+    out << kManifestHeader << "\n";
+    char opacity[32];
+    for (const auto& r : rows)
+    {
+        std::snprintf(opacity, sizeof(opacity), "%.9g", r.settings.opacity); // round-trips the float
+        out << r.output << '\t' << r.input << '\t' << r.variant << '\t' << r.seed << '\t' << r.texture << '\t'
+            << r.settings.blendMode << '\t' << opacity << '\t' << (r.settings.useTextureLuminance ? 1 : 0) << '\t'
+            << (r.settings.swapRB ? 1 : 0) << "\n";
+    }
+    return static_cast<bool>(out);
+}
+
+bool readDevelopManifest(const std::string& path, std::vector<DevelopManifestRow>& rows)
+{
+    std::ifstream in(path);
+    std::string line;
+    if (!in || !std::getline(in, line)) return false;
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    if (line != kManifestHeader) { std::cerr << "[readDevelopManifest] not a develop manifest: " << path << "\n"; return false; }
+
+    std::vector<DevelopManifestRow> parsed;
+    for (int lineNo = 2; std::getline(in, line); ++lineNo)
+    {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty()) continue;
+        std::vector<std::string> f;
+        std::stringstream ss(line);
+        for (std::string field; std::getline(ss, field, '\t');) f.push_back(field);
+        DevelopManifestRow r;
+        try
+        {
+            if (f.size() != 9) throw std::invalid_argument("field count");
+            r.output = f[0]; r.input = f[1]; r.variant = std::stoi(f[2]); r.seed = std::stoull(f[3]); r.texture = f[4];
+            r.settings.blendMode = std::stoi(f[5]); r.settings.opacity = std::stof(f[6]);
+            r.settings.useTextureLuminance = f[7] == "1"; r.settings.swapRB = f[8] == "1";
+        }
+        catch (const std::exception&)
+        {
+            std::cerr << "[readDevelopManifest] bad line " << lineNo << " in " << path << "\n";
+            return false;
+        }
+        parsed.push_back(r);
+    }
+    rows = std::move(parsed);
+    return true;
+}
@@ -0,0 +1,132 @@
+/*=========================  film_develop.hpp  =========================
+
+   Film develop: blend a scan texture (dust, light leaks, grain) over an
+   image. One engine for the export and the preview.
+   --------------------------------------------------------------------
+   • texture decode normalised to 8/16-bit, any channel count
+   • channel handling happens once per texture and target size; the
+     RGBA/BGR auto-fix and black-background neutralisation are decided
+     at the export size and reused by the preview proxy
+   • prepared textures are kept in a process-wide LRU, so a texture
+     reused across a batch is decoded and analysed once per size
+   • the blend itself is util::blendTexture
+   • "procedural:..." texture paths are synthesised at the base size
+     instead of decoded (film_grain.hpp)
+   • batches: K seeded variants per image, run in parallel with one
+     decode per image, described by a manifest that replays exactly
+   • export runs at full resolution; the preview runs the same steps on
+     a display-sized proxy of base and texture
+
+=====================================================================*/
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "models/DevelopSettings.hpp"
+
+// Texture ready to blend onto a base of `bgr.size()`
+struct DevelopTexture
+{
+    cv::Mat bgr;   // CV_8UC3 or CV_16UC3
+    cv::Mat alpha; // CV_8UC1 or CV_16UC1, same depth as bgr; empty = opaque
+};
+
+// Decodes a texture with its alpha; float images are brought to 8-bit. False if unreadable.
+bool loadDevelopTexture(const std::string& path, cv::Mat& tex);
+
+// Content-dependent colour decisions of prepareDevelopTexture
+struct DevelopTextureFlags
+{
+    bool swapRB {false};     // red and blue swapped: requested, or the blue-dominance auto-fix
+    bool neutralise {false}; // tinted features on black: luminance becomes alpha, colour goes gray
+};
+
+// The decisions for `tex` as given; the export makes them on the texture resized to the base
+// size, and a proxy reuses those so it cannot get a different treatment near the thresholds.
+DevelopTextureFlags analyseDevelopTexture(const cv::Mat& tex, const DevelopSettings& settings);
+
+/**
+ * @brief Resizes a decoded texture to `size` and derives colour and alpha from `settings`
+ *        (useTextureLuminance, swapRB). `tex` is not modified.
+ * @param interpolation resize filter; the export uses INTER_LANCZOS4, proxies INTER_AREA
+ * @param flags decisions from analyseDevelopTexture; nullptr decides on the resized texture
+ */
+bool prepareDevelopTexture(const cv::Mat& tex, cv::Size size, const DevelopSettings& settings,
+                           DevelopTexture& out, int interpolation = cv::INTER_LANCZOS4,
+                           const DevelopTextureFlags* flags = nullptr);
+
+/**
+ * @brief loadDevelopTexture + prepareDevelopTexture through the prepared-texture cache, keyed by
+ *        (path, file size and mtime, target size, interpolation, useTextureLuminance, swapRB,
+ *        export size).
+ *        Budget: DEVELOP_TEXTURE_CACHE_MB (default 2048; 0 disables); least recently used entries
+ *        go first, the newest is always kept. Concurrent requests for one key prepare it once.
+ *        Colour decisions (analyseDevelopTexture) are made once per file and `exportSize` (default:
+ *        `size`) on the texture Lanczos-resized to it, as the export always did; a proxy passes the
+ *        full base size and gets the export's treatment. Procedural paths (film_grain.hpp) are
+ *        synthesised at `size` and cached the same way.
+ * @return shared, read-only planes; nullptr if the texture cannot be read
+ */
+std::shared_ptr<const DevelopTexture> cachedDevelopTexture(const std::string& path, cv::Size size,
+                                                           const DevelopSettings& settings,
+                                                           int interpolation = cv::INTER_LANCZOS4,
+                                                           cv::Size exportSize = cv::Size());
+
+// Drops every cached texture
+void clearDevelopTextureCache();
+
+// Blends a prepared texture over `base` (CV_8UC3 at the texture's size)
+void developBlend(const cv::Mat& base, const DevelopTexture& tex, const DevelopSettings& settings, cv::Mat& out);
+
+// Full-resolution develop of `base` with a decoded texture: prepare + blend
+bool developImage(const cv::Mat& base, const cv::Mat& tex, const DevelopSettings& settings, cv::Mat& out);
+
+// ---- Batches -------------------------------------------------------------
+
+// One develop output and everything needed to regenerate it
+struct DevelopManifestRow
+{
+    std::string output;
+    std::string input;
+    std::string texture;
+    int variant {1};      // 1-based variant of `input`
+    uint64_t seed {0};    // 0 when the parameters were not drawn from a seed
+    DevelopSettings settings;
+};
+
+struct DevelopBatchOptions
+{
+    int variants {1};          // outputs per image: <stem>_developed.<ext>, or _developed_<k> when > 1
+    uint64_t seed {0};         // batch seed; per-output seeds derive from it, the file name and k
+    bool randomize {true};     // draw texture, blend mode and opacity from the seed; false = `settings` + first texture
+    DevelopSettings settings;  // texture flags always; blend mode and opacity when not randomizing
+    std::string outDir;
+};
+
+// Seed of variant `k` of the image file `imageName` (name only, so moving the folder keeps seeds)
+uint64_t developVariantSeed(uint64_t batchSeed, const std::string& imageName, int k);
+
+// Texture index, blend mode and opacity (30..80%) drawn from `seed`, identically on every platform;
+// the texture flags are copied from `base`
+void pickDevelopVariant(uint64_t seed, size_t textureCount, const DevelopSettings& base,
+                        int& texture, DevelopSettings& out);
+
+// Rows for every image x variant; nothing is read or written. Outputs are <stem>_developed[_k]<ext>;
+// a stem already used by an earlier input becomes <stem>_2, <stem>_3... (also for the seed)
+std::vector<DevelopManifestRow> planDevelopBatch(const std::vector<std::string>& images,
+                                                 const std::vector<std::string>& textures,
+                                                 const DevelopBatchOptions& options);
+
+/**
+ * @brief Develops every row at full resolution, images in parallel. Each input is decoded once for all
+ *        of its rows and textures come from cachedDevelopTexture, shared read-only between workers.
+ * @param ok optional per-row success flags
+ * @return number of outputs written
+ */
+int runDevelopRows(const std::vector<DevelopManifestRow>& rows, std::vector<bool>* ok = nullptr);
+
+// Tab-separated, one header line; paths may not contain tabs or newlines
+bool writeDevelopManifest(const std::string& path, const std::vector<DevelopManifestRow>& rows);
+bool readDevelopManifest(const std::string& path, std::vector<DevelopManifestRow>& rows);
@@ -0,0 +1,239 @@
+// Procedural grain / dust / light-leak textures
+#include "film_grain.hpp"
+#include "film_develop.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <sstream>
+#include <vector>
+
+using namespace cv;
+
+namespace
+{
+    const char* const kPrefix = "procedural:";
+
+    // Lattice value in [-1, 1] for cell (i, j); stateless so bands never depend on each other
+    inline float latticeValue(uint64_t seed, int32_t i, int32_t j)
+    {
+        uint64_t h = seed ^ (uint64_t(uint32_t(i)) * 0x9e3779b97f4a7c15ULL) ^ (uint64_t(uint32_t(j)) * 0xc2b2ae3d27d4eb4fULL);
+        h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+        h ^= h >> 31;
+        return float(h >> 40) * (2.0f / 16777215.0f) - 1.0f;
+    }
+
+    inline float smooth(float t) { return t * t * (3.0f - 2.0f * t); }
+
+    // Portable uniform draws: mt19937_64's sequence is fixed by the standard, distributions are not
+    struct Draw
+    {
+        explicit Draw(uint64_t seed) : rng(seed) {}
+        double uniform() { return double(rng() >> 11) * (1.0 / 9007199254740992.0); }
+        double uniform(double a, double b) { return a + (b - a) * uniform(); }
+        std::mt19937_64 rng;
+    };
+
+    struct Leak
+    {
+        double cx, cy, radius; // pixels
+        float color[3];        // BGR, scaled by strength
+    };
+
+    // Dust specks and hairs as an 8-bit brightness plane
+    Mat drawDust(const GrainSettings& s, Size size, double shortSide)
+    {
+        Mat dust = Mat::zeros(size, CV_8U);
+        if (s.dust <= 0.0f) return dust;
+        Draw d(s.seed ^ 0xd0570000ULL);
+        const int shift = 4; // sub-pixel positions, so small proxies place specks where the export does
+        const double one = 1 << shift;
+        auto pt = [&](double x, double y) { return Point(int(std::lround(x * one)), int(std::lround(y * one))); };
+
+        const int specks = int(std::lround(std::clamp(s.dust, 0.0f, 1.0f) * 300));
+        for (int k = 0; k < specks; ++k)
+        {
+            const double x = d.uniform() * size.width, y = d.uniform() * size.height;
+            const double r = d.uniform(0.0003, 0.0018) * shortSide;
+            double v = d.uniform(0.5, 1.0) * 255;
+            if (r < 0.5) v *= (r * r) / 0.25; // below a pixel: same energy, spread over one
+            circle(dust, pt(x, y), int(std::lround(std::max(r, 0.5) * one)), Scalar(v), FILLED, LINE_AA, shift);
+        }
+
+        const int hairs = int(std::lround(std::clamp(s.dust, 0.0f, 1.0f) * 8));
+        for (int k = 0; k < hairs; ++k)
+        {
+            std::vector<Point> line;
+            double x = d.uniform() * size.width, y = d.uniform() * size.height;
+            double angle = d.uniform(0, 2 * CV_PI);
+            const double step = d.uniform(0.004, 0.012) * shortSide;
+            for (int p = 0; p < 8; ++p)
+            {
+                line.push_back(pt(x, y));
+                angle += d.uniform(-0.5, 0.5);
+                x += std::cos(angle) * step;
+                y += std::sin(angle) * step;
+            }
+            const double w = std::max(1.0, 0.0006 * shortSide);
+            polylines(dust, line, false, Scalar(d.uniform(0.4, 0.8) * 255), int(std::lround(w)), LINE_AA, shift);
+        }
+        return dust;
+    }
+
+    std::vector<Leak> placeLeaks(const GrainSettings& s, Size size, double shortSide)
+    {
+        std::vector<Leak> leaks;
+        if (s.leak <= 0.0f) return leaks;
+        static const float palette[][3] = { { 0.20f, 0.50f, 1.00f },   // orange
+                                            { 0.15f, 0.20f, 1.00f },   // red
+                                            { 0.30f, 0.80f, 1.00f },   // yellow
+                                            { 0.70f, 0.25f, 1.00f } }; // magenta
+        Draw d(s.seed ^ 0x1ea40000ULL);
+        const int count = 1 + int(d.rng() % 3);
+        for (int k = 0; k < count; ++k)
+        {
+            // Centred just outside a frame edge, so the glow bleeds in from the side like a real leak
+            Leak l;
+            const double along = d.uniform(), out = d.uniform(0.05, 0.25) * shortSide;
+            switch (d.rng() % 4)
+            {
+            case 0: l.cx = -out; l.cy = along * size.height; break;
+            case 1: l.cx = size.width + out; l.cy = along * size.height; break;
+            case 2: l.cx = along * size.width; l.cy = -out; break;
+            default: l.cx = along * size.width; l.cy = size.height + out; break;
+            }
+            l.radius = d.uniform(0.3, 0.8) * shortSide;
+            const float* c = palette[d.rng() % 4];
+            const float a = float(std::clamp(s.leak, 0.0f, 1.0f) * d.uniform(0.5, 1.0));
+            for (int ch = 0; ch < 3; ++ch) l.color[ch] = c[ch] * a;
+            leaks.push_back(l);
+        }
+        return leaks;
+    }
+}
+
+bool isProceduralTexture(const std::string& path)
+{
+    return path.compare(0, std::char_traits<char>::length(kPrefix), kPrefix) == 0;
+}
+
+bool parseGrainSpec(const std::string& path, GrainSettings& out, bool* hasSeed)
+{
+    if (!isProceduralTexture(path)) return false;
+    GrainSettings s;
+    bool seeded = false;
+    std::stringstream ss(path.substr(std::char_traits<char>::length(kPrefix)));
+    for (std::string field; std::getline(ss, field, ',');)
+    {
+        if (field.empty()) continue;
+        const size_t eq = field.find('=');
+        if (eq == std::string::npos) return false;
+        const std::string key = field.substr(0, eq), value = field.substr(eq + 1);
+        try
+        {
+            if (key == "seed") { s.seed = std::stoull(value); seeded = true; }
+            else if (key == "grain") s.grain = std::stof(value);
+            else if (key == "size") s.size = std::stof(value);
+            else if (key == "dust") s.dust = std::stof(value);
+            else if (key == "leak") s.leak = std::stof(value);
+            else return false;
+        }
+        catch (const std::exception&) { return false; }
+    }
+    out = s;
+    if (hasSeed) *hasSeed = seeded;
+    return true;
+}
+
+std::string grainSpec(const GrainSettings& s)
+{
+    char buf[160];
+    std::snprintf(buf, sizeof(buf), "%sseed=%llu,grain=%.9g,size=%.9g,dust=%.9g,leak=%.9g", kPrefix,
+                  static_cast<unsigned long long>(s.seed), s.grain, s.size, s.dust, s.leak);
+    return buf;
+}
+
+void synthesizeGrainTexture(const GrainSettings& s, cv::Size size, DevelopTexture& out)
+{
+    CV_Assert(size.width > 0 && size.height > 0);
+    const double shortSide = std::min(size.width, size.height);
+    // Grain cells in pixels; finer than a pixel they average out, so the amplitude falls with them
+    const float cellPx = float(std::max(0.05f, s.size) * 0.0015 * shortSide);
+    const float invCell = 1.0f / std::max(1.0f, cellPx);
+    const float amp = std::clamp(s.grain, 0.0f, 1.0f) * 0.25f;
+    const float att = std::min(1.0f, cellPx);
+    const uint64_t grainSeed = s.seed ^ 0x9a1400000ULL;
+
+    const Mat dust = drawDust(s, size, shortSide);
+    const std::vector<Leak> leaks = placeLeaks(s, size, shortSide);
+
+    // Per-column lattice index and weight, and per-leak column falloff: shared by every row
+    const int W = size.width;
+    std::vector<int32_t> col(W);
+    std::vector<float> colT(W);
+    for (int x = 0; x < W; ++x)
+    {
+        const float g = (x + 0.5f) * invCell;
+        col[x] = int32_t(std::floor(g));
+        colT[x] = smooth(g - float(col[x]));
+    }
+    const int cells = col[W - 1] + 2;
+    std::vector<std::vector<float>> leakX(leaks.size(), std::vector<float>(W));
+    for (size_t k = 0; k < leaks.size(); ++k)
+    {
+        const double inv = 1.0 / (leaks[k].radius * leaks[k].radius);
+        for (int x = 0; x < W; ++x) { const double dx = x + 0.5 - leaks[k].cx; leakX[k][x] = float(std::exp(-dx * dx * inv)); }
+    }
+
+    Mat bgr(size, CV_8UC3);
+    parallel_for_(Range(0, size.height), [&](const Range& range)
+    {
+        std::vector<float> h0(cells), h1(cells), lum(W);
+        int32_t cachedJ = INT32_MIN;
+        for (int y = range.start; y < range.end; ++y)
+        {
+            const float gy = (y + 0.5f) * invCell;
+            const int32_t j = int32_t(std::floor(gy));
+            const float ty = smooth(gy - float(j));
+            if (j != cachedJ)
+            {
+                for (int i = 0; i < cells; ++i) { h0[i] = latticeValue(grainSeed, i, j); h1[i] = latticeValue(grainSeed, i, j + 1); }
+                cachedJ = j;
+            }
+            const uchar* dp = dust.ptr<uchar>(y);
+            for (int x = 0; x < W; ++x)
+            {
+                const int i = col[x];
+                const float a = h0[i] + (h0[i + 1] - h0[i]) * colT[x];
+                const float b = h1[i] + (h1[i + 1] - h1[i]) * colT[x];
+                const float n = a + (b - a) * ty;
+                lum[x] = amp * (0.5f + 0.5f * n * att) + dp[x] * (1.0f / 255.0f);
+            }
+
+            uchar* o = bgr.ptr<uchar>(y);
+            for (int x = 0; x < W; ++x)
+                for (int c = 0; c < 3; ++c) o[3 * x + c] = saturate_cast<uchar>(lum[x] * 255.0f);
+            for (size_t k = 0; k < leaks.size(); ++k)
+            {
+                const double dy = y + 0.5 - leaks[k].cy;
+                const float fy = float(std::exp(-dy * dy / (leaks[k].radius * leaks[k].radius)));
+                if (fy < 1e-4f) continue;
+                const float* lx = leakX[k].data();
+                for (int x = 0; x < W; ++x)
+                {
+                    const float f = lx[x] * fy * 255.0f;
+                    for (int c = 0; c < 3; ++c) o[3 * x + c] = saturate_cast<uchar>(o[3 * x + c] + leaks[k].color[c] * f);
+                }
+            }
+        }
+    });
+
+    // Luminance as alpha, as prepareDevelopTexture gives a black-background scan: the near-black
+    // background then barely touches the base in Multiply and the other darkening modes
+    Mat alpha; cvtColor(bgr, alpha, COLOR_BGR2GRAY);
+    out.bgr = bgr;
+    out.alpha = alpha;
+}
@@ -0,0 +1,43 @@
+/*=========================  film_grain.hpp  ===========================
+
+   Procedural film develop textures: grain, dust and light leaks
+   synthesised at the exact base size, so nothing is decoded or resized.
+   --------------------------------------------------------------------
+   • named by a texture "path" of the form
+       procedural:seed=7,grain=0.5,size=1,dust=0.3,leak=0.4
+     (any subset, in any order), so it goes wherever a texture file
+     does: the prepared-texture cache, preview, export, batches, manifests
+   • feature sizes are fractions of the short side: the display proxy and
+     the full-resolution export show the same frame
+   • black background with bright features, like the scanned textures;
+     CV_8UC3 with its luminance as alpha, so only the features blend
+   • rows are synthesised in parallel bands, each independent of the rest
+
+=====================================================================*/
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <string>
+
+struct DevelopTexture;
+
+struct GrainSettings
+{
+    uint64_t seed {0};
+    float grain {0.5f}; // grain strength, 0..1
+    float size {1.0f};  // grain size; 1 = 1.5/1000 of the short side
+    float dust {0.3f};  // dust and hair density, 0..1
+    float leak {0.4f};  // light-leak strength, 0..1 (0 = none)
+};
+
+// True for "procedural:..." texture paths
+bool isProceduralTexture(const std::string& path);
+
+// Parses a procedural texture path; unset fields keep their defaults. `hasSeed` reports whether seed= was given.
+bool parseGrainSpec(const std::string& path, GrainSettings& out, bool* hasSeed = nullptr);
+
+// Canonical path for `settings`; parseGrainSpec gives the same values back
+std::string grainSpec(const GrainSettings& settings);
+
+// Texture for a base of `size`; same settings and size, same pixels
+void synthesizeGrainTexture(const GrainSettings& settings, cv::Size size, DevelopTexture& out);
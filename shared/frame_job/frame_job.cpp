@@ -0,0 +1,39 @@
+// Shared per-input state for multi-mode batches
+#include "frame_job.hpp"
+#include "vehicle_mask.hpp"
+
+#include <iostream>
+
+const cv::Mat& FrameJob::image()
+{
+    if (!decoded_)
+    {
+        decoded_ = true;
+        image_ = cv::imread(path_);
+        if (image_.empty()) std::cerr << "[FrameJob] cannot open: " << path_ << "\n";
+    }
+    return image_;
+}
+
+const cv::Mat& FrameJob::vehicleMask(const MaskSettings& settings)
+{
+    if (haveMask_ && maskSettings_ == settings) return mask_;
+    mask_.release();
+    const cv::Mat& img = image();
+    if (!img.empty() && !generateVehicleMaskMat(img, mask_, settings, path_)) mask_.release();
+    maskSettings_ = settings;
+    haveMask_ = true;
+    return mask_;
+}
+
+const ExtendBounds* FrameJob::extendBounds(int whiteThr)
+{
+    if (!haveBounds_ || boundsThr_ != whiteThr)
+    {
+        const cv::Mat& img = image();
+        boundsFound_ = !img.empty() && detectExtendBounds(img, whiteThr, bounds_);
+        boundsThr_ = whiteThr;
+        haveBounds_ = true;
+    }
+    return boundsFound_ ? &bounds_ : nullptr;
+}
@@ -0,0 +1,46 @@
+/*==========================  frame_job.hpp  ==========================
+
+   Per-input state shared by every output of a multi-mode batch job.
+   --------------------------------------------------------------------
+   • decodes the source once
+   • computes the vehicle mask once per MaskSettings
+   • detects the extend-canvas foreground bounds once per threshold
+
+=====================================================================*/
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <string>
+#include "models/MaskSettings.hpp"
+#include "extend_canvas.hpp"
+
+class FrameJob
+{
+public:
+    explicit FrameJob(std::string path) : path_(std::move(path)) {}
+
+    const std::string& path() const { return path_; }
+
+    // Decoded BGR frame; empty if the file cannot be read
+    const cv::Mat& image();
+
+    // generateVehicleMaskMat result for `settings`; empty if the frame is unreadable
+    const cv::Mat& vehicleMask(const MaskSettings& settings);
+
+    // Extend-canvas bounds for `whiteThr` (-1 = auto); nullptr if there is no foreground
+    const ExtendBounds* extendBounds(int whiteThr);
+
+private:
+    std::string path_;
+
+    bool decoded_ {false};
+    cv::Mat image_;
+
+    bool haveMask_ {false};
+    MaskSettings maskSettings_;
+    cv::Mat mask_;
+
+    bool haveBounds_ {false};
+    bool boundsFound_ {false};
+    int boundsThr_ {-1};
+    ExtendBounds bounds_;
+};
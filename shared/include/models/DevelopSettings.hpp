@@ -0,0 +1,13 @@
+/**
+ * @file DevelopSettings.hpp
+ * Film develop parameters: how a texture is blended over the base image.
+ */
+#pragma once
+
+struct DevelopSettings
+{
+    int blendMode {1};                // util::TextureBlendMode: 0=multiply, 1=screen, 2=lighten, ...
+    float opacity {0.5f};             // 0..1, multiplied into the per-pixel texture alpha
+    bool useTextureLuminance {false}; // texture luminance becomes alpha and the texture is neutralised to gray
+    bool swapRB {false};              // swap the texture's R/B (otherwise a blue-dominance heuristic decides)
+};
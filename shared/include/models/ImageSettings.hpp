@@ -14,6 +14,9 @@ struct ImageSettings
     int finalHeight {-1};
     int blurRadius {0};
     bool stretchIfNeeded {false};
+    bool proceduralBackground {false}; // synthesise strips from a fitted background model instead of stretching
+    bool backgroundGrain {true};       // add the measured background noise to procedural strips
+    bool extendHorizontal {false};     // fit the car band inside the canvas and extend the sides too
 
     ImageSettings() = default;
     ImageSettings(int w, int h) : width(w), height(h) {}
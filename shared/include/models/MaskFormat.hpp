@@ -0,0 +1,14 @@
+/**
+ * @file MaskFormat.hpp
+ * On-disk encodings for exported vehicle masks (see shared/vehicle_mask/mask_io.hpp).
+ */
+#pragma once
+
+enum class MaskFormat
+{
+    Png8 = 0,      // 8-bit greyscale PNG, <stem>_mask.png
+    Png1 = 1,      // 1-bit PNG, <stem>_mask.png
+    Rle = 2,       // run-length sidecar, <stem>_mask.rle
+    AlphaPng = 3,  // source with the mask as alpha, <stem>_cutout.png
+    AlphaWebp = 4, // same in WebP (lossy colour, lossless alpha), <stem>_cutout.webp
+};
@@ -14,6 +14,7 @@ struct MaskSettings
     int morphKernel {7};     // odd size (3,5,7,...)
     int dilateIters {2};
     int erodeIters {0};
+    bool fastMorphology {false}; // distance-transform dilate/erode: cost independent of kernel and iterations
 
     // White cyc assistance
     bool useWhiteCycAssist {true};
@@ -23,5 +24,19 @@ struct MaskSettings
     int minArea {5000};      // remove small components (in px)
     int featherRadius {0};   // Gaussian blur radius; 0 = off
     bool invert {false};     // output background white (true) or object white (false)
+
+    // Speed
+    int workingSize {0};     // long edge (px) of a downscaled mask pass, guided-upsampled to full res; 0 = full res
+    bool restrictToForeground {false}; // run the heavy stages only inside the padded non-white bounds
+
+    bool operator==(const MaskSettings& o) const
+    {
+        return cannyLow == o.cannyLow && cannyHigh == o.cannyHigh && morphKernel == o.morphKernel &&
+               dilateIters == o.dilateIters && erodeIters == o.erodeIters && fastMorphology == o.fastMorphology &&
+               useWhiteCycAssist == o.useWhiteCycAssist && whiteThreshold == o.whiteThreshold &&
+               minArea == o.minArea && featherRadius == o.featherRadius && invert == o.invert &&
+               workingSize == o.workingSize && restrictToForeground == o.restrictToForeground;
+    }
+    bool operator!=(const MaskSettings& o) const { return !(*this == o); }
 };
 
@@ -0,0 +1,26 @@
+/**
+ * @file RenditionSet.hpp
+ * Named list of output targets produced from one decode/detection per input.
+ */
+#pragma once
+#include <string>
+#include <vector>
+
+struct Rendition
+{
+    std::string name;        // output suffix: <stem>_<name>.<ext>
+    int width {0};           // canvas size, as ImageSettings::width/height (0 = source size)
+    int height {0};
+    int finalWidth {-1};     // optional letterboxed final size, as ImageSettings::finalWidth/finalHeight
+    int finalHeight {-1};
+    std::string format;      // "jpg", "png", "webp", ...; empty = same as input
+    int quality {95};        // JPEG/WebP quality 1..100 (ignored for lossless formats)
+};
+
+struct RenditionSet
+{
+    std::string name;
+    std::vector<Rendition> renditions;
+
+    bool empty() const { return renditions.empty(); }
+};
@@ -0,0 +1,34 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <string>
+
+namespace util {
+
+// Values are stored in settings and manifests: append new modes, never reorder
+enum TextureBlendMode
+{
+    BlendMultiply = 0, BlendScreen = 1, BlendLighten = 2,
+    BlendOverlay, BlendSoftLight, BlendHardLight, BlendColorDodge, BlendColorBurn,
+    BlendDarken, BlendDifference, BlendAdd,
+    BlendModeCount
+};
+
+// Lower-case mode name ("multiply", "soft-light", ...); nullptr when out of range
+const char* blendModeName(int mode);
+// Inverse of blendModeName; -1 when unknown
+int blendModeFromName(const std::string& name);
+
+// out = base * (1 - a) + blend(base, tex) * a, with a = alpha * opacity per pixel.
+// One fused scalar pass per row in 16-bit fixed point (8-bit inputs are widened exactly), rows in
+// parallel; no float planes or per-channel temporaries. Each mode is a 256x256 table of blend(base, tex), so an
+// 8-bit pixel costs one fetch plus the alpha lerp; 16-bit textures interpolate the table along tex,
+// except for Multiply/Screen/Lighten, which keep their exact integer forms.
+//   base : CV_8UC3
+//   tex  : CV_8UC3 or CV_16UC3, same size as base
+//   alpha: CV_8UC1 or CV_16UC1, same size as base; empty = opaque
+//   mode : TextureBlendMode (anything else is Lighten, as in the UI)
+// `out` is CV_8UC3 and may be `base`.
+void blendTexture(const cv::Mat& base, const cv::Mat& tex, const cv::Mat& alpha, cv::Mat& out,
+                  int mode, float opacity);
+
+}
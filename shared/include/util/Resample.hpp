@@ -0,0 +1,12 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+
+namespace util {
+
+// `region` (clipped to dsize) of cv::resize(src, ., dsize, 0, 0, interpolation), within ±1; dst empty if none is left
+void resampleRegion(const cv::Mat& src, cv::Mat& dst, cv::Size dsize, cv::Rect region, int interpolation);
+
+// Release all cached filter banks
+void clearResampleCache();
+
+}
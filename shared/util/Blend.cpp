@@ -0,0 +1,201 @@
+#include "util/Blend.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace util {
+
+namespace {
+
+constexpr uint32_t kOne = 65535;
+constexpr int kLutStride = 257; // 256 tex columns + a copy of the last, so interpolation never branches
+
+// round(x / 65535) for x <= 65535 * 65535, without a divide
+inline uint32_t div65535(uint32_t x)
+{
+    x += 32768;
+    return (x + (x >> 16)) >> 16;
+}
+
+// Sample to the 16-bit scale: v * 257 maps 0..255 onto 0..65535 exactly
+inline uint32_t widen(uchar v) { return uint32_t(v) * 257; }
+inline uint32_t widen(ushort v) { return v; }
+
+// The original integer modes; their tables are filled from these so 8-bit results are unchanged
+template <int Mode>
+inline uint32_t fixedBlend(uint32_t B, uint32_t T)
+{
+    if (Mode == BlendMultiply) return div65535(B * T);
+    if (Mode == BlendScreen) return kOne - div65535((kOne - B) * (kOne - T));
+    return std::max(B, T);
+}
+
+// Table definitions for everything else, on 0..1 (b = base, t = texture)
+double overlay(double b, double t) { return b < 0.5 ? 2 * b * t : 1 - 2 * (1 - b) * (1 - t); }
+double hardLight(double b, double t) { return overlay(t, b); }
+double softLight(double b, double t) // W3C compositing spec
+{
+    if (t <= 0.5) return b - (1 - 2 * t) * b * (1 - b);
+    const double d = b <= 0.25 ? ((16 * b - 12) * b + 4) * b : std::sqrt(b);
+    return b + (2 * t - 1) * (d - b);
+}
+double colorDodge(double b, double t) { return b <= 0 ? 0 : t >= 1 ? 1 : std::min(1.0, b / (1 - t)); }
+double colorBurn(double b, double t) { return b >= 1 ? 1 : t <= 0 ? 0 : 1 - std::min(1.0, (1 - b) / t); }
+double darken(double b, double t) { return std::min(b, t); }
+double difference(double b, double t) { return std::abs(b - t); }
+double add(double b, double t) { return std::min(1.0, b + t); }
+
+struct ModeDef
+{
+    const char* name;
+    double (*fn)(double b, double t); // nullptr: one of the fixed-point modes
+};
+
+const ModeDef kModes[BlendModeCount] = {
+    { "multiply", nullptr },
+    { "screen", nullptr },
+    { "lighten", nullptr },
+    { "overlay", overlay },
+    { "soft-light", softLight },
+    { "hard-light", hardLight },
+    { "color-dodge", colorDodge },
+    { "color-burn", colorBurn },
+    { "darken", darken },
+    { "difference", difference },
+    { "add", add },
+};
+
+uint32_t lutEntry(int mode, int b, int t)
+{
+    switch (mode)
+    {
+    case BlendMultiply: return fixedBlend<BlendMultiply>(widen(uchar(b)), widen(uchar(t)));
+    case BlendScreen: return fixedBlend<BlendScreen>(widen(uchar(b)), widen(uchar(t)));
+    case BlendLighten: return fixedBlend<BlendLighten>(widen(uchar(b)), widen(uchar(t)));
+    default: return static_cast<uint32_t>(std::lround(std::clamp(kModes[mode].fn(b / 255.0, t / 255.0), 0.0, 1.0) * kOne));
+    }
+}
+
+// blend(b, t) on the 16-bit scale at [b * kLutStride + t]; built on first use, then read-only
+const uint16_t* blendLut(int mode)
+{
+    static std::once_flag once[BlendModeCount];
+    static std::vector<uint16_t> luts[BlendModeCount];
+    std::call_once(once[mode], [mode]
+    {
+        std::vector<uint16_t>& lut = luts[mode];
+        lut.resize(256 * kLutStride);
+        for (int b = 0; b < 256; ++b)
+        {
+            uint16_t* row = &lut[b * kLutStride];
+            for (int t = 0; t < 256; ++t) row[t] = static_cast<uint16_t>(lutEntry(mode, b, t));
+            row[256] = row[255];
+        }
+    });
+    return luts[mode].data();
+}
+
+// Table value for a texture sample: direct for 8-bit, linear between the two nearest columns for 16-bit
+inline uint32_t lookup(const uint16_t* row, uchar t) { return row[t]; }
+inline uint32_t lookup(const uint16_t* row, ushort t)
+{
+    const uint32_t j = t / 257u, r = t - j * 257u; // t = j * 257 + r, r in 0..256
+    return (row[j] * (257u - r) + row[j + 1] * r + 128u) / 257u;
+}
+
+// Effective per-pixel alpha (alpha * opacity) for one row
+template <typename TA>
+void alphaRow(const TA* a, int n, uint32_t opacity, uint32_t* dst)
+{
+    for (int x = 0; x < n; ++x) dst[x] = div65535(widen(a[x]) * opacity);
+}
+
+template <typename TT>
+void lutRow(const uchar* b, const TT* t, const uint32_t* a, const uint16_t* lut, uchar* out, int n)
+{
+    for (int x = 0; x < n; ++x)
+    {
+        const uint32_t ax = a[x], ia = kOne - ax;
+        for (int c = 0; c < 3; ++c)
+        {
+            const uchar bv = b[3 * x + c];
+            const uint32_t C = lookup(lut + bv * kLutStride, t[3 * x + c]);
+            out[3 * x + c] = static_cast<uchar>(div65535(div65535(widen(bv) * ia + C * ax) * 255));
+        }
+    }
+}
+
+template <int Mode>
+void fixedRow(const uchar* b, const ushort* t, const uint32_t* a, uchar* out, int n)
+{
+    for (int x = 0; x < n; ++x)
+    {
+        const uint32_t ax = a[x], ia = kOne - ax;
+        for (int c = 0; c < 3; ++c)
+        {
+            const uint32_t B = widen(b[3 * x + c]), T = t[3 * x + c];
+            const uint32_t C = fixedBlend<Mode>(B, T);
+            out[3 * x + c] = static_cast<uchar>(div65535(div65535(B * ia + C * ax) * 255));
+        }
+    }
+}
+
+template <typename TT>
+void blendRows(const cv::Mat& base, const cv::Mat& tex, const cv::Mat& alpha, cv::Mat& out, int mode, uint32_t opacity)
+{
+    const int n = base.cols;
+    // 16-bit textures under the original modes keep the exact formula; everything else is a table fetch
+    const bool fixed = tex.depth() == CV_16U && mode <= BlendLighten;
+    const uint16_t* lut = fixed ? nullptr : blendLut(mode);
+    cv::parallel_for_(cv::Range(0, base.rows), [&](const cv::Range& r)
+    {
+        std::vector<uint32_t> a(n, opacity);
+        for (int y = r.start; y < r.end; ++y)
+        {
+            if (alpha.depth() == CV_8U) alphaRow(alpha.ptr<uchar>(y), n, opacity, a.data());
+            else if (alpha.depth() == CV_16U) alphaRow(alpha.ptr<ushort>(y), n, opacity, a.data());
+            const uchar* b = base.ptr<uchar>(y);
+            const TT* t = tex.ptr<TT>(y);
+            uchar* o = out.ptr<uchar>(y);
+            if (!fixed) { lutRow(b, t, a.data(), lut, o, n); continue; }
+            const ushort* t16 = tex.ptr<ushort>(y);
+            switch (mode)
+            {
+            case BlendMultiply: fixedRow<BlendMultiply>(b, t16, a.data(), o, n); break;
+            case BlendScreen: fixedRow<BlendScreen>(b, t16, a.data(), o, n); break;
+            default: fixedRow<BlendLighten>(b, t16, a.data(), o, n); break;
+            }
+        }
+    });
+}
+
+}
+
+const char* blendModeName(int mode)
+{
+    return (mode >= 0 && mode < BlendModeCount) ? kModes[mode].name : nullptr;
+}
+
+int blendModeFromName(const std::string& name)
+{
+    for (int m = 0; m < BlendModeCount; ++m)
+        if (name == kModes[m].name) return m;
+    return -1;
+}
+
+void blendTexture(const cv::Mat& base, const cv::Mat& tex, const cv::Mat& alpha, cv::Mat& out,
+                  int mode, float opacity)
+{
+    CV_Assert(base.type() == CV_8UC3 && tex.size() == base.size() &&
+              (tex.type() == CV_8UC3 || tex.type() == CV_16UC3));
+    CV_Assert(alpha.empty() || (alpha.size() == base.size() && (alpha.type() == CV_8UC1 || alpha.type() == CV_16UC1)));
+    if (mode < 0 || mode >= BlendModeCount) mode = BlendLighten;
+    const uint32_t op = static_cast<uint32_t>(std::lround(std::clamp(opacity, 0.0f, 1.0f) * kOne));
+    out.create(base.size(), CV_8UC3); // keeps base's buffer when out is base
+    if (tex.depth() == CV_16U) blendRows<ushort>(base, tex, alpha, out, mode, op);
+    else blendRows<uchar>(base, tex, alpha, out, mode, op);
+}
+
+}
@@ -0,0 +1,305 @@
+#include "util/Resample.hpp"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+namespace util {
+
+namespace {
+
+// One axis of a separable filter: every output index reads `taps` source indices
+// (already clamped to the image, i.e. replicate border) with normalised weights.
+struct AxisBank
+{
+    int taps {0};
+    std::vector<int> ofs;    // dstLen * taps source indices
+    std::vector<float> w;    // dstLen * taps weights
+};
+
+struct ResamplePlan
+{
+    AxisBank x, y;
+    std::vector<int> xofsElem; // x.ofs pre-multiplied by the channel count
+    // Filter columns first when rows shrink, so the scalar horizontal gather runs on output rows
+    // rather than on every source row; fixed per plan, so every window of it agrees
+    bool verticalFirst {false};
+};
+
+using PlanKey = std::tuple<int, int, int, int, int, int>; // srcW, srcH, dstW, dstH, interpolation, channels
+
+// Least recently used first; the map points into the list
+std::mutex g_planMutex;
+std::list<std::pair<PlanKey, std::shared_ptr<const ResamplePlan>>> g_planOrder;
+std::map<PlanKey, decltype(g_planOrder)::iterator> g_plans;
+constexpr size_t kMaxPlans = 64;
+
+// Same sampling geometry as cv::resize INTER_LANCZOS4 (8 taps, kernel not widened on downscale)
+AxisBank buildLanczos4(int srcLen, int dstLen)
+{
+    AxisBank b;
+    b.taps = 8;
+    b.ofs.resize(static_cast<size_t>(dstLen) * 8);
+    b.w.resize(static_cast<size_t>(dstLen) * 8);
+    const double scale = static_cast<double>(srcLen) / dstLen;
+    for (int i = 0; i < dstLen; ++i)
+    {
+        const double fx = (i + 0.5) * scale - 0.5;
+        const int sx = static_cast<int>(std::floor(fx));
+        const double t = fx - sx;
+        double c[8];
+        double sum = 0.0;
+        for (int k = 0; k < 8; ++k)
+        {
+            if (t < FLT_EPSILON) { c[k] = (k == 3) ? 1.0 : 0.0; }
+            else
+            {
+                const double d = (t + 3 - k) * CV_PI;
+                c[k] = 4.0 * std::sin(d) * std::sin(d * 0.25) / (d * d);
+            }
+            sum += c[k];
+        }
+        for (int k = 0; k < 8; ++k)
+        {
+            b.ofs[i * 8 + k] = std::clamp(sx - 3 + k, 0, srcLen - 1);
+            b.w[i * 8 + k] = static_cast<float>(c[k] / sum);
+        }
+    }
+    return b;
+}
+
+// Box coverage weights, as cv::resize INTER_AREA computes them for shrinking (srcLen >= dstLen)
+AxisBank buildArea(int srcLen, int dstLen)
+{
+    const double scale = static_cast<double>(srcLen) / dstLen;
+    std::vector<std::vector<std::pair<int, double>>> rows(dstLen);
+    int taps = 1;
+    for (int i = 0; i < dstLen; ++i)
+    {
+        const double f1 = i * scale, f2 = f1 + scale;
+        const int s1 = static_cast<int>(std::ceil(f1)), s2 = static_cast<int>(std::floor(f2));
+        auto& r = rows[i];
+        if (s1 - f1 > 1e-3) r.emplace_back(s1 - 1, s1 - f1);
+        for (int j = s1; j < s2; ++j) r.emplace_back(j, 1.0);
+        if (f2 - s2 > 1e-3 && s2 < srcLen) r.emplace_back(s2, f2 - s2);
+        if (r.empty()) r.emplace_back(std::min(s1, srcLen - 1), 1.0);
+        taps = std::max(taps, static_cast<int>(r.size()));
+    }
+    AxisBank b;
+    b.taps = taps;
+    b.ofs.assign(static_cast<size_t>(dstLen) * taps, 0);
+    b.w.assign(static_cast<size_t>(dstLen) * taps, 0.0f);
+    for (int i = 0; i < dstLen; ++i)
+    {
+        const auto& r = rows[i];
+        double sum = 0.0;
+        for (const auto& e : r) sum += e.second;
+        for (int k = 0; k < taps; ++k)
+        {
+            // Pad short rows with zero-weight taps on the last index so offsets stay monotonic
+            const auto& e = r[std::min<size_t>(k, r.size() - 1)];
+            b.ofs[i * taps + k] = std::clamp(e.first, 0, srcLen - 1);
+            b.w[i * taps + k] = k < static_cast<int>(r.size()) ? static_cast<float>(e.second / sum) : 0.0f;
+        }
+    }
+    return b;
+}
+
+bool bankSupported(const cv::Mat& src, cv::Size dsize, int interpolation)
+{
+    const bool shrinking = dsize.width <= src.cols && dsize.height <= src.rows;
+    return !src.empty() && src.depth() == CV_8U && dsize.width > 0 && dsize.height > 0 &&
+           (interpolation == cv::INTER_LANCZOS4 || (interpolation == cv::INTER_AREA && shrinking));
+}
+
+std::shared_ptr<const ResamplePlan> getPlan(cv::Size src, cv::Size dst, int interpolation, int cn)
+{
+    const PlanKey key(src.width, src.height, dst.width, dst.height, interpolation, cn);
+    std::lock_guard<std::mutex> lock(g_planMutex);
+    auto it = g_plans.find(key);
+    if (it != g_plans.end())
+    {
+        g_planOrder.splice(g_planOrder.begin(), g_planOrder, it->second);
+        return it->second->second;
+    }
+
+    auto plan = std::make_shared<ResamplePlan>();
+    if (interpolation == cv::INTER_AREA)
+    {
+        plan->x = buildArea(src.width, dst.width);
+        plan->y = buildArea(src.height, dst.height);
+    }
+    else
+    {
+        plan->x = buildLanczos4(src.width, dst.width);
+        plan->y = buildLanczos4(src.height, dst.height);
+    }
+    plan->xofsElem.resize(plan->x.ofs.size());
+    for (size_t i = 0; i < plan->x.ofs.size(); ++i) plan->xofsElem[i] = plan->x.ofs[i] * cn;
+    plan->verticalFirst = dst.height < src.height;
+
+    if (g_plans.size() >= kMaxPlans)
+    {
+        g_plans.erase(g_planOrder.back().first);
+        g_planOrder.pop_back();
+    }
+    g_planOrder.emplace_front(key, plan);
+    g_plans.emplace(key, g_planOrder.begin());
+    return plan;
+}
+
+// One row through the horizontal bank: `s` is a source row (uchar) or a vertically filtered one
+// (float) whose first element is source element `shift`. CN > 0 fixes the channel count so the
+// per-pixel channel loop unrolls.
+template <int CN, typename T>
+inline void filterRowN(const T* s, float* d, int dstW, int cnRuntime, const int* xofs, const float* xw, int tx, int shift)
+{
+    const int cn = CN > 0 ? CN : cnRuntime;
+    for (int x = 0; x < dstW; ++x)
+    {
+        const int* xo = xofs + x * tx;
+        const float* w = xw + x * tx;
+        if (CN == 3)
+        {
+            float a0 = 0.0f, a1 = 0.0f, a2 = 0.0f;
+            for (int k = 0; k < tx; ++k)
+            {
+                const T* p = s + (xo[k] - shift);
+                a0 += w[k] * p[0]; a1 += w[k] * p[1]; a2 += w[k] * p[2];
+            }
+            d[x * 3] = a0; d[x * 3 + 1] = a1; d[x * 3 + 2] = a2;
+        }
+        else
+        {
+            for (int c = 0; c < cn; ++c)
+            {
+                float v = 0.0f;
+                for (int k = 0; k < tx; ++k) v += w[k] * s[xo[k] - shift + c];
+                d[x * cn + c] = v;
+            }
+        }
+    }
+}
+
+template <typename T>
+inline void filterRow(const T* s, float* d, int dstW, int cn, const int* xofs, const float* xw, int tx, int shift)
+{
+    if (cn == 3) filterRowN<3>(s, d, dstW, cn, xofs, xw, tx, shift);
+    else if (cn == 1) filterRowN<1>(s, d, dstW, cn, xofs, xw, tx, shift);
+    else filterRowN<0>(s, d, dstW, cn, xofs, xw, tx, shift);
+}
+
+// Fills `out` with the window of the planned output whose top-left corner is `origin`
+void runPlan(const cv::Mat& src, cv::Mat& out, const ResamplePlan& plan, cv::Point origin = cv::Point())
+{
+    const int cn = src.channels();
+    const int dstW = out.cols, dstH = out.rows;
+    const int ox = origin.x, oy = origin.y;
+    const int rowLen = dstW * cn;
+    const int tx = plan.x.taps, ty = plan.y.taps;
+    const int stripes = std::max(1, std::min(dstH, cv::getNumThreads() * 4));
+
+    const int* xofs = plan.xofsElem.data() + ox * tx;
+    const float* xw = plan.x.w.data() + ox * tx;
+
+    if (plan.verticalFirst)
+    {
+        // Source columns under the window
+        int lo = src.cols, hi = -1;
+        for (int i = ox * tx; i < (ox + dstW) * tx; ++i) { lo = std::min(lo, plan.x.ofs[i]); hi = std::max(hi, plan.x.ofs[i]); }
+        const int shift = lo * cn, colLen = (hi - lo + 1) * cn;
+
+        cv::parallel_for_(cv::Range(0, dstH), [&](const cv::Range& r)
+        {
+            static thread_local std::vector<float> vbuf;
+            static thread_local std::vector<float> acc;
+            vbuf.resize(colLen);
+            acc.resize(rowLen);
+            for (int y = r.start; y < r.end; ++y)
+            {
+                // Vertical pass over the window's columns, one flat loop per tap so it vectorises
+                std::fill(vbuf.begin(), vbuf.end(), 0.0f);
+                for (int k = 0; k < ty; ++k)
+                {
+                    const float wk = plan.y.w[(y + oy) * ty + k];
+                    if (wk == 0.0f) continue;
+                    const uchar* s = src.ptr<uchar>(plan.y.ofs[(y + oy) * ty + k]) + shift;
+                    for (int i = 0; i < colLen; ++i) vbuf[i] += wk * s[i];
+                }
+                filterRow(vbuf.data(), acc.data(), dstW, cn, xofs, xw, tx, shift);
+                uchar* d = out.ptr<uchar>(y);
+                for (int i = 0; i < rowLen; ++i) d[i] = cv::saturate_cast<uchar>(acc[i]);
+            }
+        }, stripes);
+        return;
+    }
+
+    cv::parallel_for_(cv::Range(0, dstH), [&](const cv::Range& r)
+    {
+        // Source rows touched by this block of output rows
+        int lo = src.rows, hi = -1;
+        for (int i = (r.start + oy) * ty; i < (r.end + oy) * ty; ++i) { lo = std::min(lo, plan.y.ofs[i]); hi = std::max(hi, plan.y.ofs[i]); }
+        const int nrows = hi - lo + 1;
+
+        // Per-thread scratch, kept across calls so batches stop reallocating
+        static thread_local std::vector<float> hbuf;
+        static thread_local std::vector<float> acc;
+        hbuf.resize(static_cast<size_t>(nrows) * rowLen);
+        acc.resize(rowLen);
+
+        // Horizontal pass into float rows
+        for (int sy = lo; sy <= hi; ++sy)
+            filterRow(src.ptr<uchar>(sy), hbuf.data() + static_cast<size_t>(sy - lo) * rowLen, dstW, cn, xofs, xw, tx, 0);
+
+        // Vertical pass, one flat loop per tap so it vectorises
+        for (int y = r.start; y < r.end; ++y)
+        {
+            std::fill(acc.begin(), acc.end(), 0.0f);
+            for (int k = 0; k < ty; ++k)
+            {
+                const float wk = plan.y.w[(y + oy) * ty + k];
+                if (wk == 0.0f) continue;
+                const float* h = hbuf.data() + static_cast<size_t>(plan.y.ofs[(y + oy) * ty + k] - lo) * rowLen;
+                for (int i = 0; i < rowLen; ++i) acc[i] += wk * h[i];
+            }
+            uchar* d = out.ptr<uchar>(y);
+            for (int i = 0; i < rowLen; ++i) d[i] = cv::saturate_cast<uchar>(acc[i]);
+        }
+    }, stripes);
+}
+
+}
+
+void resampleRegion(const cv::Mat& src, cv::Mat& dst, cv::Size dsize, cv::Rect region, int interpolation)
+{
+    region &= cv::Rect(0, 0, dsize.width, dsize.height);
+    if (region.empty()) { dst.release(); return; }
+    // The banks only pay off by skipping work: from half the output on, cv::resize and a crop is faster
+    const bool smallWindow = 2.0 * region.area() < double(dsize.width) * dsize.height;
+    if (!bankSupported(src, dsize, interpolation) || dsize == src.size() || !smallWindow)
+    {
+        cv::Mat full;
+        cv::resize(src, full, dsize, 0, 0, interpolation);
+        dst = full(region).clone();
+        return;
+    }
+
+    auto plan = getPlan(src.size(), dsize, interpolation, src.channels());
+    cv::Mat out(region.size(), src.type());
+    runPlan(src, out, *plan, region.tl());
+    dst = out;
+}
+
+void clearResampleCache()
+{
+    std::lock_guard<std::mutex> lock(g_planMutex);
+    g_plans.clear();
+    g_planOrder.clear();
+}
+
+}
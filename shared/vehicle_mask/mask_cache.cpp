@@ -0,0 +1,341 @@
+#include "mask_cache.hpp"
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace cv;
+namespace fs = std::filesystem;
+
+namespace {
+    // Streaming XXH64: fast enough that hashing a file costs a fraction of decoding it
+    class Hash64
+    {
+    public:
+        explicit Hash64(uint64_t seed = 0) : seed_(seed)
+        {
+            v_[0] = seed + P1 + P2; v_[1] = seed + P2; v_[2] = seed; v_[3] = seed - P1;
+        }
+
+        void update(const void* data, size_t len)
+        {
+            const unsigned char* p = static_cast<const unsigned char*>(data);
+            total_ += len;
+            if (tailLen_ > 0)
+            {
+                const size_t n = std::min(len, sizeof(tail_) - tailLen_);
+                std::memcpy(tail_ + tailLen_, p, n);
+                tailLen_ += n; p += n; len -= n;
+                if (tailLen_ < sizeof(tail_)) return;
+                stripe(tail_);
+                tailLen_ = 0;
+            }
+            for (; len >= 32; p += 32, len -= 32) stripe(p);
+            std::memcpy(tail_, p, len);
+            tailLen_ = len;
+        }
+
+        uint64_t digest() const
+        {
+            uint64_t h;
+            if (total_ >= 32)
+            {
+                h = rotl(v_[0], 1) + rotl(v_[1], 7) + rotl(v_[2], 12) + rotl(v_[3], 18);
+                for (uint64_t v : v_) h = (h ^ round(0, v)) * P1 + P4;
+            }
+            else
+            {
+                h = seed_ + P5;
+            }
+            h += total_;
+            const unsigned char* p = tail_;
+            size_t len = tailLen_;
+            for (; len >= 8; p += 8, len -= 8) h = rotl(h ^ round(0, read64(p)), 27) * P1 + P4;
+            if (len >= 4) { h = rotl(h ^ (uint64_t(read32(p)) * P1), 23) * P2 + P3; p += 4; len -= 4; }
+            for (; len > 0; ++p, --len) h = rotl(h ^ (*p * P5), 11) * P1;
+            h ^= h >> 33; h *= P2; h ^= h >> 29; h *= P3; h ^= h >> 32;
+            return h;
+        }
+
+    private:
+        static constexpr uint64_t P1 = 11400714785074694791ULL, P2 = 14029467366897019727ULL,
+                                  P3 = 1609587929392839161ULL, P4 = 9650029242287828579ULL,
+                                  P5 = 2870177450012600261ULL;
+        static uint64_t rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+        static uint64_t round(uint64_t acc, uint64_t in) { return rotl(acc + in * P2, 31) * P1; }
+        static uint64_t read64(const unsigned char* p) { uint64_t v; std::memcpy(&v, p, 8); return v; } // little-endian hosts
+        static uint32_t read32(const unsigned char* p) { uint32_t v; std::memcpy(&v, p, 4); return v; }
+        void stripe(const unsigned char* p) { for (int i = 0; i < 4; ++i) v_[i] = round(v_[i], read64(p + 8 * i)); }
+
+        uint64_t seed_;
+        uint64_t v_[4];
+        uint64_t total_ {0};
+        unsigned char tail_[32];
+        size_t tailLen_ {0};
+    };
+
+    std::string hex(uint64_t v)
+    {
+        char buf[17];
+        std::snprintf(buf, sizeof(buf), "%016llx", static_cast<unsigned long long>(v));
+        return buf;
+    }
+
+    bool isPng(const std::string& path)
+    {
+        std::string ext = fs::path(path).extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c){ return char(std::tolower(c)); });
+        return ext == ".png";
+    }
+
+    std::string defaultDirectory()
+    {
+        auto env = [](const char* name) { const char* v = std::getenv(name); return std::string(v ? v : ""); };
+        fs::path base;
+#if defined(_WIN32)
+        base = env("LOCALAPPDATA");
+#elif defined(__APPLE__)
+        if (!env("HOME").empty()) base = fs::path(env("HOME")) / "Library" / "Caches";
+#else
+        base = env("XDG_CACHE_HOME");
+        if (base.empty() && !env("HOME").empty()) base = fs::path(env("HOME")) / ".cache";
+#endif
+        return base.empty() ? std::string() : (base / "extend_canvas" / "masks").string();
+    }
+
+    std::string entryPath(const std::string& fileKey, const MaskSettings& s, const std::string& backend)
+    {
+        // Two-level fan-out keeps directories small on large libraries
+        return (fs::path(maskcache::directory()) / fileKey.substr(0, 2) /
+                (fileKey + "-" + maskcache::settingsKey(s) + "-" + backend + ".png")).string();
+    }
+
+    // Unique sibling of `entry` to write before the rename; keeps the .png extension for imwrite
+    std::string tempPath(const std::string& entry)
+    {
+        static std::atomic<unsigned long long> serial {0};
+        const size_t tid = std::hash<std::thread::id>()(std::this_thread::get_id());
+        return entry + "." + std::to_string(tid) + "_" + std::to_string(++serial) + ".tmp.png";
+    }
+
+    uintmax_t budget()
+    {
+        static const uintmax_t bytes = []
+        {
+            const char* v = std::getenv("MASK_CACHE_MB");
+            const long long mb = v ? std::atoll(v) : 1024;
+            return static_cast<uintmax_t>(std::max(0LL, mb)) << 20;
+        }();
+        return bytes;
+    }
+
+    // Bytes in the cache as this process last saw them; scanned on the first store, then kept up to date
+    std::mutex g_sizeMutex;
+    bool g_sizeKnown = false;
+    uintmax_t g_size = 0;
+
+    // Drops least recently used entries (oldest mtime; loads refresh it) until the cache is at 3/4 of
+    // its budget, so pruning runs once per quarter budget written rather than on every store
+    void prune()
+    {
+        struct Entry { fs::file_time_type mtime; uintmax_t size; fs::path path; };
+        std::vector<Entry> entries;
+        uintmax_t total = 0;
+        std::error_code ec;
+        for (fs::recursive_directory_iterator it(maskcache::directory(), ec), end; !ec && it != end; it.increment(ec))
+        {
+            // Entries only: in-flight temp files belong to another writer
+            std::error_code entryEc;
+            const std::string name = it->path().filename().string();
+            if (!it->is_regular_file(entryEc) || it->path().extension() != ".png" || name.find(".tmp.") != std::string::npos) continue;
+            const uintmax_t size = it->file_size(entryEc);
+            const fs::file_time_type mtime = it->last_write_time(entryEc);
+            if (entryEc) continue;
+            entries.push_back({ mtime, size, it->path() });
+            total += size;
+        }
+        const uintmax_t cap = budget();
+        if (total > cap)
+        {
+            std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.mtime < b.mtime; });
+            for (const auto& e : entries)
+            {
+                if (total <= cap / 4 * 3) break;
+                if (fs::remove(e.path, ec)) total -= e.size; // another run may have removed it already
+            }
+        }
+        g_size = total;
+    }
+
+    void account(const std::string& entry)
+    {
+        if (budget() == 0) return; // MASK_CACHE_MB=0: no cap
+        std::error_code ec;
+        const uintmax_t size = fs::file_size(entry, ec);
+        std::lock_guard<std::mutex> lock(g_sizeMutex);
+        if (!g_sizeKnown) { prune(); g_sizeKnown = true; }
+        else if (!ec) g_size += size;
+        if (g_size > budget()) prune();
+    }
+
+    void touch(const std::string& entry)
+    {
+        std::error_code ec;
+        fs::last_write_time(entry, fs::file_time_type::clock::now(), ec);
+    }
+
+    bool commit(const std::string& tmp, const std::string& entry)
+    {
+        std::error_code ec;
+        fs::rename(tmp, entry, ec); // atomic on POSIX; an existing entry holds the same mask anyway
+        if (!ec) { account(entry); return true; }
+        fs::remove(tmp, ec);
+        return false;
+    }
+
+    struct KeyMemo
+    {
+        uintmax_t size;
+        fs::file_time_type mtime;
+        std::string key;
+    };
+}
+
+namespace maskcache {
+
+const std::string& directory()
+{
+    static const std::string dir = []
+    {
+        const char* v = std::getenv("MASK_CACHE_DIR");
+        if (!v) return defaultDirectory();
+        const std::string s(v);
+        return (s.empty() || s == "0" || s == "off") ? std::string() : s;
+    }();
+    return dir;
+}
+
+bool enabled() { return !directory().empty(); }
+
+std::string fileKey(const std::string& path)
+{
+    if (!enabled()) return std::string();
+    std::error_code ec;
+    const uintmax_t size = fs::file_size(path, ec);
+    if (ec) return std::string();
+    const fs::file_time_type mtime = fs::last_write_time(path, ec);
+    if (ec) return std::string();
+
+    // Previews ask again on every settings change; only rehash when the file changed
+    static std::mutex mutex;
+    static std::unordered_map<std::string, KeyMemo> memo;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = memo.find(path);
+        if (it != memo.end() && it->second.size == size && it->second.mtime == mtime) return it->second.key;
+    }
+
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return std::string();
+    Hash64 h;
+    std::vector<char> buf(1 << 20);
+    while (in)
+    {
+        in.read(buf.data(), static_cast<std::streamsize>(buf.size()));
+        h.update(buf.data(), static_cast<size_t>(in.gcount()));
+    }
+    const std::string key = hex(h.digest());
+
+    std::lock_guard<std::mutex> lock(mutex);
+    memo[path] = KeyMemo{ size, mtime, key };
+    return key;
+}
+
+std::string settingsKey(const MaskSettings& s)
+{
+    // Versioned so a change to the mask algorithm can retire old entries
+    const int fields[] = { 1, s.cannyLow, s.cannyHigh, s.morphKernel, s.dilateIters, s.erodeIters, s.fastMorphology,
+                           s.useWhiteCycAssist, s.whiteThreshold, s.minArea, s.featherRadius, s.invert,
+                           s.workingSize, s.restrictToForeground };
+    Hash64 h;
+    h.update(fields, sizeof(fields));
+    return hex(h.digest());
+}
+
+std::string textKey(const std::string& text)
+{
+    Hash64 h;
+    h.update(text.data(), text.size());
+    return hex(h.digest());
+}
+
+bool load(const std::string& fileKey, const MaskSettings& settings, const std::string& backend, cv::Mat& mask)
+{
+    if (fileKey.empty() || !enabled()) return false;
+    const std::string entry = entryPath(fileKey, settings, backend);
+    Mat m = imread(entry, IMREAD_GRAYSCALE);
+    if (m.empty()) return false;
+    touch(entry);
+    mask = m;
+    return true;
+}
+
+bool loadTo(const std::string& fileKey, const MaskSettings& settings, const std::string& backend, const std::string& outPath)
+{
+    if (fileKey.empty() || !enabled()) return false;
+    const std::string entry = entryPath(fileKey, settings, backend);
+    std::error_code ec;
+    if (!fs::exists(entry, ec)) return false;
+    touch(entry);
+    fs::create_directories(fs::path(outPath).parent_path(), ec);
+    if (isPng(outPath))
+        return fs::copy_file(entry, outPath, fs::copy_options::overwrite_existing, ec) && !ec;
+    Mat m = imread(entry, IMREAD_GRAYSCALE);
+    return !m.empty() && imwrite(outPath, m);
+}
+
+void store(const std::string& fileKey, const MaskSettings& settings, const std::string& backend, const cv::Mat& mask,
+           const std::string& writtenPath)
+{
+    if (fileKey.empty() || mask.empty() || !enabled()) return;
+    if (!writtenPath.empty() && isPng(writtenPath)) { storeFile(fileKey, settings, backend, writtenPath); return; }
+    const std::string entry = entryPath(fileKey, settings, backend);
+    std::error_code ec;
+    fs::create_directories(fs::path(entry).parent_path(), ec);
+    const std::string tmp = tempPath(entry);
+    bool ok = false;
+    try { ok = imwrite(tmp, mask); } catch (const cv::Exception&) {}
+    if (!ok || !commit(tmp, entry))
+    {
+        fs::remove(tmp, ec);
+        std::cerr << "[maskcache] cannot write " << entry << "\n";
+    }
+}
+
+void storeFile(const std::string& fileKey, const MaskSettings& settings, const std::string& backend, const std::string& maskPath)
+{
+    if (fileKey.empty() || !enabled() || !isPng(maskPath)) return;
+    const std::string entry = entryPath(fileKey, settings, backend);
+    std::error_code ec;
+    fs::create_directories(fs::path(entry).parent_path(), ec);
+    const std::string tmp = tempPath(entry);
+    if (!fs::copy_file(maskPath, tmp, fs::copy_options::overwrite_existing, ec) || !commit(tmp, entry))
+    {
+        fs::remove(tmp, ec);
+        std::cerr << "[maskcache] cannot write " << entry << "\n";
+    }
+}
+
+}
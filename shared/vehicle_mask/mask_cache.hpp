@@ -0,0 +1,54 @@
+/*=========================  mask_cache.hpp  =========================
+
+   Persistent on-disk cache of vehicle masks, so revisiting an image
+   (mask preview, Auto Fit preview/export, batches) skips segmentation.
+   --------------------------------------------------------------------
+   • key = content hash of the input file + MaskSettings hash + backend
+   • entries are 8-bit PNGs under MASK_CACHE_DIR (default
+     <user cache dir>/extend_canvas/masks); MASK_CACHE_DIR=off disables
+   • writes go to a temp file and are renamed into place, so concurrent
+     batches and a crashed run never leave a partial entry
+   • capped at MASK_CACHE_MB (default 1024, 0 = no cap): past it the
+     least recently used entries go (loads refresh an entry's mtime)
+   • unreadable entries are misses; delete the directory to clear it
+
+=====================================================================*/
+#pragma once
+#include <string>
+#include "models/MaskSettings.hpp"
+
+namespace cv { class Mat; }
+
+namespace maskcache {
+
+// Backend of masks computed in-process by computeVehicleMaskMat. Script masks use
+// "sam2-<model hash>" or "script-<backend>" so one never stands in for another.
+inline const char* const kHeuristic = "opencv";
+
+bool enabled();
+const std::string& directory();
+
+// 64-bit content hash of the file as 16 hex digits (memoised per path, size and mtime);
+// empty if the cache is off or the file cannot be read
+std::string fileKey(const std::string& path);
+
+// Hash of every MaskSettings field
+std::string settingsKey(const MaskSettings& settings);
+
+// Hash of arbitrary text, e.g. a model name in a backend tag
+std::string textKey(const std::string& text);
+
+// Cached mask for the entry, CV_8U {0,255}
+bool load(const std::string& fileKey, const MaskSettings& settings, const std::string& backend, cv::Mat& mask);
+
+// Writes the cached mask to `outPath` (a plain file copy for .png outputs)
+bool loadTo(const std::string& fileKey, const MaskSettings& settings, const std::string& backend, const std::string& outPath);
+
+// Both no-op when the key is empty or the cache is off; failures only log.
+// If `writtenPath` is a PNG of `mask` already on disk, it is copied instead of encoding again.
+void store(const std::string& fileKey, const MaskSettings& settings, const std::string& backend, const cv::Mat& mask,
+           const std::string& writtenPath = std::string());
+// Caches a PNG mask written elsewhere (e.g. by the script); other formats may be lossy and are skipped
+void storeFile(const std::string& fileKey, const MaskSettings& settings, const std::string& backend, const std::string& maskPath);
+
+}
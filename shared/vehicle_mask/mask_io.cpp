@@ -0,0 +1,207 @@
+#include "mask_io.hpp"
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+using namespace cv;
+
+namespace {
+    const unsigned char kRleMagic[4] = { 'V', 'M', 'R', 'L' };
+    const size_t kRleHeader = 16;
+    const uint64_t kMaxRlePixels = uint64_t(1) << 30; // OpenCV's default CV_IO_MAX_IMAGE_PIXELS
+    const uchar kSetLevel = 128; // binary formats cut a feathered edge at its midpoint
+
+    void putU32(std::vector<unsigned char>& out, uint32_t v)
+    {
+        for (int i = 0; i < 4; ++i) out.push_back(static_cast<unsigned char>(v >> (8 * i)));
+    }
+
+    uint32_t getU32(const unsigned char* p)
+    {
+        return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+    }
+
+    void putVarint(std::vector<unsigned char>& out, uint64_t v)
+    {
+        while (v >= 0x80) { out.push_back(static_cast<unsigned char>(v | 0x80)); v >>= 7; }
+        out.push_back(static_cast<unsigned char>(v));
+    }
+
+    bool getVarint(const unsigned char*& p, const unsigned char* end, uint64_t& v)
+    {
+        v = 0;
+        for (int shift = 0; p < end && shift < 64; shift += 7)
+        {
+            const unsigned char b = *p++;
+            v |= uint64_t(b & 0x7f) << shift;
+            if (!(b & 0x80)) return true;
+        }
+        return false;
+    }
+
+    std::string lowerExt(const std::string& path)
+    {
+        std::string ext = std::filesystem::path(path).extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c){ return char(std::tolower(c)); });
+        return ext;
+    }
+
+    // Source BGR + mask as alpha in one pass
+    bool composeBgra(const Mat& source, const Mat& mask, Mat& bgra)
+    {
+        if (source.empty() || source.size() != mask.size() || source.depth() != CV_8U) return false;
+        Mat bgr = source;
+        if (source.channels() == 1) cvtColor(source, bgr, COLOR_GRAY2BGR);
+        else if (source.channels() == 4) cvtColor(source, bgr, COLOR_BGRA2BGR);
+        bgra.create(mask.size(), CV_8UC4);
+        const Mat srcs[] = { bgr, mask };
+        const int fromTo[] = { 0, 0, 1, 1, 2, 2, 3, 3 };
+        mixChannels(srcs, 2, &bgra, 1, fromTo, 4);
+        return true;
+    }
+}
+
+std::string maskFileSuffix(MaskFormat format)
+{
+    switch (format)
+    {
+    case MaskFormat::Rle: return "_mask.rle";
+    case MaskFormat::AlphaPng: return "_cutout.png";
+    case MaskFormat::AlphaWebp: return "_cutout.webp";
+    case MaskFormat::Png1:
+    case MaskFormat::Png8:
+    default: return "_mask.png";
+    }
+}
+
+void encodeMaskRle(const cv::Mat& mask, std::vector<unsigned char>& out)
+{
+    CV_Assert(mask.type() == CV_8U);
+    out.clear();
+    out.insert(out.end(), kRleMagic, kRleMagic + 4);
+    out.push_back(1);
+    out.insert(out.end(), 3, 0);
+    putU32(out, static_cast<uint32_t>(mask.cols));
+    putU32(out, static_cast<uint32_t>(mask.rows));
+
+    // Runs continue across row ends; a run is emitted when the value flips at the set level
+    bool set = false;
+    uint64_t run = 0;
+    for (int y = 0; y < mask.rows; ++y)
+    {
+        const uchar* p = mask.ptr<uchar>(y);
+        int x = 0;
+        while (x < mask.cols)
+        {
+            const int start = x;
+            if (set) while (x < mask.cols && p[x] >= kSetLevel) ++x;
+            else     while (x < mask.cols && p[x] < kSetLevel) ++x;
+            run += uint64_t(x - start);
+            if (x < mask.cols) { putVarint(out, run); run = 0; set = !set; }
+        }
+    }
+    putVarint(out, run);
+}
+
+bool decodeMaskRle(const unsigned char* data, size_t size, cv::Mat& mask)
+{
+    if (size < kRleHeader || std::memcmp(data, kRleMagic, 4) != 0 || data[4] != 1) return false;
+    const uint32_t w = getU32(data + 8), h = getU32(data + 12);
+    // A corrupt header must not ask for an allocation the caller cannot survive
+    if (w == 0 || h == 0 || w > 0x7fffffffu || h > 0x7fffffffu || uint64_t(w) * h > kMaxRlePixels) return false;
+
+    Mat m(static_cast<int>(h), static_cast<int>(w), CV_8U);
+    const uint64_t total = uint64_t(w) * h;
+    uchar* dst = m.data;
+    const unsigned char* p = data + kRleHeader;
+    const unsigned char* end = data + size;
+    uint64_t pos = 0;
+    uchar value = 0;
+    while (pos < total)
+    {
+        uint64_t run;
+        if (!getVarint(p, end, run) || run > total - pos) return false;
+        std::memset(dst + pos, value, static_cast<size_t>(run));
+        pos += run;
+        value ^= 255;
+    }
+    mask = m;
+    return true;
+}
+
+bool writeMask(const std::string& path, const cv::Mat& mask, MaskFormat format, const cv::Mat* source)
+{
+    if (mask.empty() || mask.type() != CV_8U) return false;
+    try
+    {
+        switch (format)
+        {
+        case MaskFormat::Png1:
+        {
+            // libpng packs any non-zero as 1; threshold first so a feather is cut, not grown
+            Mat bin; threshold(mask, bin, kSetLevel - 1, 255, THRESH_BINARY);
+            return imwrite(path, bin, { IMWRITE_PNG_BILEVEL, 1 });
+        }
+        case MaskFormat::Rle:
+        {
+            std::vector<unsigned char> bytes;
+            encodeMaskRle(mask, bytes);
+            std::ofstream out(path, std::ios::binary | std::ios::trunc);
+            out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+            return static_cast<bool>(out);
+        }
+        case MaskFormat::AlphaPng:
+        case MaskFormat::AlphaWebp:
+        {
+            Mat bgra;
+            if (!source || !composeBgra(*source, mask, bgra))
+            {
+                std::cerr << "[writeMask] cutout needs the source frame at the mask size: " << path << "\n";
+                return false;
+            }
+            if (format == MaskFormat::AlphaWebp) return imwrite(path, bgra, { IMWRITE_WEBP_QUALITY, 95 });
+            return imwrite(path, bgra);
+        }
+        case MaskFormat::Png8:
+        default:
+            return imwrite(path, mask);
+        }
+    }
+    catch (const cv::Exception& e)
+    {
+        std::cerr << "[writeMask] " << e.what() << "\n";
+        return false;
+    }
+}
+
+bool readMask(const std::string& path, cv::Mat& mask)
+{
+    if (lowerExt(path) == ".rle")
+    {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) return false;
+        try
+        {
+            const std::vector<unsigned char> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            return decodeMaskRle(bytes.data(), bytes.size(), mask);
+        }
+        catch (const std::exception& e) // cv::Exception or bad_alloc
+        {
+            std::cerr << "[readMask] " << path << ": " << e.what() << "\n";
+            return false;
+        }
+    }
+    Mat img;
+    try { img = imread(path, IMREAD_UNCHANGED); } catch (const cv::Exception&) { return false; }
+    if (img.empty() || img.depth() != CV_8U) return false;
+    if (img.channels() == 4) extractChannel(img, mask, 3);
+    else if (img.channels() == 3) cvtColor(img, mask, COLOR_BGR2GRAY);
+    else mask = img;
+    return true;
+}
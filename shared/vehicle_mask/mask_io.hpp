@@ -0,0 +1,39 @@
+/*==========================  mask_io.hpp  ==========================
+
+   Compact writers and matching fast readers for exported vehicle masks.
+   --------------------------------------------------------------------
+   • Png8 / Png1: greyscale PNG, 8-bit or packed 1-bit (8x fewer raw bytes)
+   • Rle: "VMRL" sidecar, no codec; see the layout below
+   • AlphaPng / AlphaWebp: the source frame with the mask as its alpha,
+     one encode and one file for photo + mask
+   • readMask() accepts any of them and returns CV_8U {0,255}
+
+   RLE layout (little-endian):
+     "VMRL"  u8 version (1)  u8[3] reserved  u32 width  u32 height
+     LEB128 run lengths over the row-major pixels, alternating 0 and 255,
+     starting with 0 (the first run may be empty); runs sum to width*height,
+     at most 2^30 pixels
+
+=====================================================================*/
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "models/MaskFormat.hpp"
+
+namespace cv { class Mat; }
+
+// Output name suffix including the extension, e.g. "_mask.png", "_mask.rle", "_cutout.webp"
+std::string maskFileSuffix(MaskFormat format);
+
+// Writes `mask` (CV_8U). Png8 and the alpha formats keep its levels; Png1 and Rle are binary, set
+// where >= 128, so a feathered edge is cut at its midpoint. The alpha formats need the `source` frame it was computed
+// from (BGR, same size); false if it is missing or the write fails.
+bool writeMask(const std::string& path, const cv::Mat& mask, MaskFormat format, const cv::Mat* source = nullptr);
+
+// Mask from any writeMask() output (alpha channel for 4-channel images, format by extension/magic)
+bool readMask(const std::string& path, cv::Mat& mask);
+
+// In-memory RLE codec used by the sidecar
+void encodeMaskRle(const cv::Mat& mask, std::vector<unsigned char>& out);
+bool decodeMaskRle(const unsigned char* data, size_t size, cv::Mat& mask);
@@ -0,0 +1,504 @@
+// Persistent mask worker processes
+#include "mask_worker_pool.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <thread>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+struct MaskWorkerPool::Worker
+{
+    int pid {-1};
+    int fd {-1};
+    bool alive {false};
+    bool busy {false};
+    int restarts {0};
+
+    // Anonymous shared segment for pixel handoff, passed to the worker as a descriptor; replaced when
+    // it must grow. Nothing is left behind in /dev/shm if either side crashes.
+    unsigned char* shm {nullptr};
+    size_t shmSize {0};
+};
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    int envInt(const char* name, int def)
+    {
+        const char* v = std::getenv(name);
+        if (!v || !*v) return def;
+        try { return std::stoi(v); } catch (...) { return def; }
+    }
+
+#ifndef _WIN32
+#ifdef MSG_NOSIGNAL
+    constexpr int kSendFlags = MSG_NOSIGNAL;
+#else
+    constexpr int kSendFlags = 0; // SO_NOSIGPIPE is set on the socket
+#endif
+
+    bool writeAll(int fd, const char* data, size_t n)
+    {
+        while (n > 0)
+        {
+            ssize_t k = ::send(fd, data, n, kSendFlags);
+            if (k < 0 && errno == EINTR) continue;
+            if (k <= 0) return false;
+            data += k; n -= static_cast<size_t>(k);
+        }
+        return true;
+    }
+
+    bool readAll(int fd, char* data, size_t n, Clock::time_point deadline)
+    {
+        while (n > 0)
+        {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+            if (left <= 0) return false;
+            pollfd p { fd, POLLIN, 0 };
+            int r = ::poll(&p, 1, static_cast<int>(std::min<long long>(left, 1000)));
+            if (r < 0 && errno == EINTR) continue;
+            if (r < 0) return false;
+            if (r == 0) continue;
+            ssize_t k = ::read(fd, data, n);
+            if (k < 0 && errno == EINTR) continue;
+            if (k <= 0) return false; // EOF: worker exited
+            data += k; n -= static_cast<size_t>(k);
+        }
+        return true;
+    }
+
+    // Frame = 4-byte little-endian length + UTF-8 text. `passFd` (if any) rides on the length
+    // prefix as SCM_RIGHTS; the worker reads every frame with recvmsg.
+    bool sendFrame(int fd, const std::string& text, int passFd = -1)
+    {
+        const uint32_t n = static_cast<uint32_t>(text.size());
+        char head[4] = { char(n & 0xFF), char((n >> 8) & 0xFF), char((n >> 16) & 0xFF), char((n >> 24) & 0xFF) };
+        size_t sent = 0;
+        if (passFd >= 0)
+        {
+            iovec iov { head, sizeof(head) };
+            alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))] = {};
+            msghdr m {};
+            m.msg_iov = &iov;
+            m.msg_iovlen = 1;
+            m.msg_control = control;
+            m.msg_controllen = sizeof(control);
+            cmsghdr* c = CMSG_FIRSTHDR(&m);
+            c->cmsg_level = SOL_SOCKET;
+            c->cmsg_type = SCM_RIGHTS;
+            c->cmsg_len = CMSG_LEN(sizeof(int));
+            std::memcpy(CMSG_DATA(c), &passFd, sizeof(int));
+            ssize_t k;
+            do k = ::sendmsg(fd, &m, kSendFlags); while (k < 0 && errno == EINTR);
+            if (k <= 0) return false;
+            sent = static_cast<size_t>(k);
+        }
+        return writeAll(fd, head + sent, sizeof(head) - sent) && writeAll(fd, text.data(), text.size());
+    }
+
+    bool recvFrame(int fd, std::string& text, int timeoutMs)
+    {
+        const auto deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+        unsigned char head[4];
+        if (!readAll(fd, reinterpret_cast<char*>(head), 4, deadline)) return false;
+        const uint32_t n = head[0] | (head[1] << 8) | (head[2] << 16) | (uint32_t(head[3]) << 24);
+        if (n > (64u << 20)) return false; // not our protocol
+        text.assign(n, '\0');
+        return n == 0 || readAll(fd, &text[0], n, deadline);
+    }
+#endif
+
+    bool safeField(const std::string& s) { return s.find_first_of("\t\n") == std::string::npos; }
+
+    std::string requestLine(const MaskRequest& r)
+    {
+        const MaskSettings& s = r.settings;
+        std::ostringstream o;
+        o << r.inPath << '\t' << r.outPath << '\t' << s.cannyLow << '\t' << s.cannyHigh << '\t' << s.morphKernel << '\t'
+          << s.dilateIters << '\t' << s.erodeIters << '\t' << (s.useWhiteCycAssist ? 1 : 0) << '\t' << s.whiteThreshold << '\t'
+          << s.minArea << '\t' << s.featherRadius << '\t' << (s.invert ? 1 : 0) << '\t' << (s.fastMorphology ? 1 : 0) << '\t'
+          << s.workingSize << '\t' << (s.restrictToForeground ? 1 : 0);
+        return o.str();
+    }
+}
+
+MaskWorkerPool::MaskWorkerPool(Options options) : opt_(std::move(options))
+{
+    opt_.workers = std::max(1, opt_.workers);
+    opt_.batchSize = std::max(1, opt_.batchSize);
+    opt_.timeoutMs = std::max(1000, opt_.timeoutMs);
+}
+
+MaskWorkerPool::~MaskWorkerPool()
+{
+#ifndef _WIN32
+    for (auto& w : workers_)
+    {
+        if (!w->alive) continue;
+        // EOF on stdin ends the worker loop; give it a moment before killing
+        ::shutdown(w->fd, SHUT_WR);
+        for (int i = 0; i < 20 && ::waitpid(w->pid, nullptr, WNOHANG) == 0; ++i)
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        kill(*w);
+    }
+#endif
+}
+
+bool MaskWorkerPool::start()
+{
+    if (!workers_.empty()) return ready();
+    for (int i = 0; i < opt_.workers; ++i)
+    {
+        workers_.push_back(std::make_unique<Worker>());
+        if (!spawn(*workers_.back()) && i == 0) break; // first refusal (e.g. SAM2 missing) applies to all
+    }
+    return ready();
+}
+
+bool MaskWorkerPool::spawn(Worker& w)
+{
+#ifdef _WIN32
+    (void)w;
+    return false;
+#else
+    int sv[2];
+    int type = SOCK_STREAM;
+#ifdef SOCK_CLOEXEC
+    type |= SOCK_CLOEXEC; // keep concurrent spawns from inheriting each other's ends
+#endif
+    if (::socketpair(AF_UNIX, type, 0, sv) != 0) return false;
+    ::fcntl(sv[0], F_SETFD, FD_CLOEXEC);
+#ifdef SO_NOSIGPIPE
+    int one = 1; ::setsockopt(sv[0], SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+    std::vector<std::string> args { opt_.python, opt_.script, "--worker" };
+    if (opt_.allowHeuristic) args.push_back("--allow-heuristic");
+    std::vector<char*> argv;
+    for (auto& a : args) argv.push_back(&a[0]);
+    argv.push_back(nullptr);
+
+    pid_t pid = ::fork();
+    if (pid < 0) { ::close(sv[0]); ::close(sv[1]); return false; }
+    if (pid == 0)
+    {
+        ::dup2(sv[1], 0);
+        ::dup2(sv[1], 1);
+        ::close(sv[0]);
+        if (sv[1] > 1) ::close(sv[1]);
+        ::execvp(argv[0], argv.data());
+        ::_exit(127);
+    }
+    ::close(sv[1]);
+    w.pid = pid;
+    w.fd = sv[0];
+
+    std::string hello;
+    if (!recvFrame(w.fd, hello, opt_.timeoutMs) || hello.rfind("READY", 0) != 0)
+    {
+        std::cerr << "[MaskWorkerPool] worker not available"
+                  << (hello.empty() ? std::string() : ": " + hello) << "\n";
+        kill(w);
+        return false;
+    }
+    {
+        // "READY <backend> [shm]"
+        std::istringstream caps(hello.substr(5));
+        std::string backend, cap;
+        caps >> backend;
+        bool shm = false;
+        while (caps >> cap) shm = shm || cap == "shm";
+        std::lock_guard<std::mutex> lock(mutex_);
+        backend_ = backend;
+        sharedMemory_ = shm;
+    }
+    w.alive = true;
+    ++readyCount_;
+    return true;
+#endif
+}
+
+void MaskWorkerPool::kill(Worker& w)
+{
+#ifndef _WIN32
+    if (w.fd >= 0) { ::close(w.fd); w.fd = -1; }
+    if (w.pid > 0)
+    {
+        if (::waitpid(w.pid, nullptr, WNOHANG) == 0)
+        {
+            ::kill(w.pid, SIGKILL);
+            ::waitpid(w.pid, nullptr, 0);
+        }
+        w.pid = -1;
+    }
+    if (w.shm)
+    {
+        ::munmap(w.shm, w.shmSize);
+        w.shm = nullptr; w.shmSize = 0;
+    }
+#endif
+    if (w.alive) { w.alive = false; --readyCount_; }
+}
+
+bool MaskWorkerPool::exchange(Worker& w, const std::string& msg, unsigned long long id, size_t count,
+                              std::vector<std::string>& replies, int passFd)
+{
+#ifdef _WIN32
+    (void)w; (void)msg; (void)id; (void)count; (void)replies; (void)passFd;
+    return false;
+#else
+    if (!sendFrame(w.fd, msg, passFd)) return false;
+    std::string reply;
+    const long long waitMs = 1LL * opt_.timeoutMs * std::max<size_t>(count, 1);
+    if (!recvFrame(w.fd, reply, static_cast<int>(std::min<long long>(waitMs, 24LL * 3600 * 1000))))
+    {
+        std::cerr << "[MaskWorkerPool] worker " << w.pid << " timed out or exited\n";
+        return false;
+    }
+    std::istringstream in(reply);
+    std::string line, tag;
+    unsigned long long rid = 0; size_t n = 0;
+    if (!std::getline(in, line)) return false;
+    std::istringstream head(line);
+    if (!(head >> tag >> rid >> n) || tag != "OK" || rid != id || n != count) return false;
+    replies.assign(count, std::string());
+    for (size_t i = 0; i < count && std::getline(in, line); ++i) replies[i] = line;
+    return true;
+#endif
+}
+
+bool MaskWorkerPool::runBatch(Worker& w, const MaskRequest* reqs, size_t count, std::vector<char>& out, size_t offset)
+{
+    const unsigned long long id = nextId_++;
+    std::string msg = "MASK " + std::to_string(id) + " " + std::to_string(count);
+    for (size_t i = 0; i < count; ++i) msg += "\n" + requestLine(reqs[i]);
+    std::vector<std::string> replies;
+    if (!exchange(w, msg, id, count, replies)) return false;
+    for (size_t i = 0; i < count; ++i)
+    {
+        out[offset + i] = !replies[i].empty() && replies[i][0] == '1';
+        if (!out[offset + i]) std::cerr << "[MaskWorkerPool] " << reqs[i].inPath << ": " << (replies[i].size() > 2 ? replies[i].substr(2) : replies[i]) << "\n";
+    }
+    return true;
+}
+
+bool MaskWorkerPool::ensureSegment(Worker& w, size_t bytes)
+{
+#ifdef _WIN32
+    (void)w; (void)bytes;
+    return false;
+#else
+    if (w.shm && w.shmSize >= bytes) return true;
+    if (w.shm)
+    {
+        ::munmap(w.shm, w.shmSize);
+        w.shm = nullptr; w.shmSize = 0;
+    }
+    const size_t size = std::max<size_t>(bytes, 1 << 20);
+#ifdef __linux__
+    int fd = ::memfd_create("ecm_frames", MFD_CLOEXEC);
+#else
+    // No memfd: a named segment whose name is dropped at once, so only the descriptors keep it alive
+    static std::atomic<unsigned> serial {0};
+    const std::string name = "/ecm" + std::to_string(::getpid()) + "_" + std::to_string(serial++); // macOS: <= 31 chars
+    int fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd >= 0) ::shm_unlink(name.c_str());
+#endif
+    if (fd < 0) { std::cerr << "[MaskWorkerPool] cannot create shared memory: " << std::strerror(errno) << "\n"; return false; }
+    void* p = ::ftruncate(fd, static_cast<off_t>(size)) == 0 ? ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+    if (p == MAP_FAILED)
+    {
+        std::cerr << "[MaskWorkerPool] cannot map " << size << " bytes of shared memory\n";
+        ::close(fd);
+        return false;
+    }
+    // "SEGMENT <id> <bytes>" carries the descriptor; the worker maps it and replies "OK <id> 0"
+    const unsigned long long id = nextId_++;
+    std::vector<std::string> none;
+    const bool attached = exchange(w, "SEGMENT " + std::to_string(id) + " " + std::to_string(size), id, 0, none, fd);
+    ::close(fd);
+    if (!attached)
+    {
+        std::cerr << "[MaskWorkerPool] worker " << w.pid << " did not map the frame segment\n";
+        ::munmap(p, size);
+        return false;
+    }
+    w.shm = static_cast<unsigned char*>(p);
+    w.shmSize = size;
+    return true;
+#endif
+}
+
+bool MaskWorkerPool::runBufferBatch(Worker& w, const MaskBufferRequest* reqs, size_t count, std::vector<char>& out, size_t offset)
+{
+    // Layout: [frame 0][mask 0][frame 1][mask 1]..., each block 64-byte aligned, frames tightly packed
+    auto align = [](size_t v) { return (v + 63) & ~size_t(63); };
+    std::vector<size_t> frameOff(count), maskOff(count);
+    size_t total = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        const size_t px = size_t(reqs[i].width) * size_t(reqs[i].height);
+        frameOff[i] = total; total = align(total + px * 3);
+        maskOff[i] = total;  total = align(total + px);
+    }
+    if (!ensureSegment(w, total)) return false;
+
+    const unsigned long long id = nextId_++;
+    std::string msg = "MASKBUF " + std::to_string(id) + " " + std::to_string(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        const MaskBufferRequest& r = reqs[i];
+        const size_t row = size_t(r.width) * 3;
+        for (int y = 0; y < r.height; ++y)
+            std::memcpy(w.shm + frameOff[i] + y * row, r.bgr + y * r.step, row);
+        MaskRequest settingsOnly { std::string(), std::string(), r.settings };
+        const std::string line = requestLine(settingsOnly);
+        msg += "\n" + std::to_string(frameOff[i]) + "\t" + std::to_string(r.width) + "\t" + std::to_string(r.height) + "\t" +
+               std::to_string(row) + "\t" + std::to_string(maskOff[i]) + line.substr(1); // drop the empty in/out fields
+    }
+    std::vector<std::string> replies;
+    if (!exchange(w, msg, id, count, replies)) return false;
+    for (size_t i = 0; i < count; ++i)
+    {
+        out[offset + i] = !replies[i].empty() && replies[i][0] == '1';
+        if (out[offset + i])
+            std::memcpy(reqs[i].mask, w.shm + maskOff[i], size_t(reqs[i].width) * size_t(reqs[i].height));
+        else
+            std::cerr << "[MaskWorkerPool] frame " << (offset + i) << ": " << (replies[i].size() > 2 ? replies[i].substr(2) : replies[i]) << "\n";
+    }
+    return true;
+}
+
+MaskWorkerPool::Worker* MaskWorkerPool::acquire()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;)
+    {
+        bool anyBusy = false;
+        for (auto& w : workers_)
+        {
+            if (w->busy) { anyBusy = true; continue; }
+            if (w->alive) { w->busy = true; return w.get(); }
+        }
+        if (!anyBusy) return nullptr; // every worker is dead
+        freeCv_.wait(lock);
+    }
+}
+
+void MaskWorkerPool::release(Worker* w)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        w->busy = false;
+    }
+    freeCv_.notify_all();
+}
+
+void MaskWorkerPool::dispatch(size_t total, const std::function<bool(Worker&, size_t, size_t)>& batch)
+{
+    const size_t bs = static_cast<size_t>(opt_.batchSize);
+    const size_t batches = (total + bs - 1) / bs;
+    std::atomic<size_t> next {0};
+    auto body = [&]()
+    {
+        for (;;)
+        {
+            const size_t b = next++;
+            if (b >= batches) return;
+            const size_t off = b * bs, cnt = std::min(bs, total - off);
+            Worker* w = acquire();
+            if (!w) return;
+            bool ok = batch(*w, off, cnt);
+            if (!ok)
+            {
+                // Crash/hang: replace the process and retry the batch once
+                kill(*w);
+                if (w->restarts < opt_.maxRestarts)
+                {
+                    ++w->restarts;
+                    if (spawn(*w)) ok = batch(*w, off, cnt);
+                    if (!ok) kill(*w);
+                }
+            }
+            release(w);
+        }
+    };
+    const size_t threads = std::min(batches, workers_.size());
+    std::vector<std::thread> pool;
+    for (size_t t = 1; t < threads; ++t) pool.emplace_back(body);
+    body();
+    for (auto& t : pool) t.join();
+}
+
+std::vector<bool> MaskWorkerPool::run(const std::vector<MaskRequest>& reqs)
+{
+    std::vector<bool> results(reqs.size(), false);
+    if (!ready() || reqs.empty()) return results;
+
+    // Paths are tab/newline separated on the wire; anything else goes to the caller's fallback
+    std::vector<MaskRequest> sendable;
+    std::vector<size_t> index;
+    for (size_t i = 0; i < reqs.size(); ++i)
+        if (safeField(reqs[i].inPath) && safeField(reqs[i].outPath)) { sendable.push_back(reqs[i]); index.push_back(i); }
+
+    std::vector<char> sent(sendable.size(), 0); // not vector<bool>: batches finish on different threads
+    dispatch(sendable.size(), [&](Worker& w, size_t off, size_t cnt) { return runBatch(w, &sendable[off], cnt, sent, off); });
+    for (size_t i = 0; i < sent.size(); ++i) results[index[i]] = sent[i] != 0;
+    return results;
+}
+
+std::vector<bool> MaskWorkerPool::runBuffers(const std::vector<MaskBufferRequest>& reqs)
+{
+    std::vector<bool> results(reqs.size(), false);
+    if (!ready() || !sharedMemory() || reqs.empty()) return results;
+    std::vector<char> done(reqs.size(), 0);
+    dispatch(reqs.size(), [&](Worker& w, size_t off, size_t cnt) { return runBufferBatch(w, &reqs[off], cnt, done, off); });
+    for (size_t i = 0; i < done.size(); ++i) results[i] = done[i] != 0;
+    return results;
+}
+
+MaskWorkerPool* MaskWorkerPool::shared(const std::string& script)
+{
+    static std::mutex m;
+    static std::map<std::string, std::unique_ptr<MaskWorkerPool>> pools;
+    static std::set<std::string> unavailable;
+    std::lock_guard<std::mutex> lock(m);
+    if (unavailable.count(script)) return nullptr;
+    auto it = pools.find(script);
+    if (it != pools.end()) return it->second.get();
+
+    Options o;
+    o.script = script;
+    if (const char* py = std::getenv("SAM2_PYTHON")) if (*py) o.python = py;
+    o.workers = envInt("SAM2_WORKERS", 2);
+    o.batchSize = envInt("SAM2_BATCH", 4);
+    o.timeoutMs = envInt("SAM2_TIMEOUT_MS", 60000);
+    o.allowHeuristic = envInt("SAM2_ALLOW_HEURISTIC", 0) != 0;
+    if (o.workers <= 0) { unavailable.insert(script); return nullptr; } // SAM2_WORKERS=0: one process per image
+
+    auto pool = std::make_unique<MaskWorkerPool>(o);
+    if (!pool->start()) { unavailable.insert(script); return nullptr; }
+    return pools.emplace(script, std::move(pool)).first->second.get();
+}
@@ -0,0 +1,104 @@
+/*=======================  mask_worker_pool.hpp  =======================
+
+   Pool of long-lived mask script processes (scripts/sam2_vehicle_mask.py
+   --worker) so Python start-up and model load are paid once per process.
+   --------------------------------------------------------------------
+   • length-prefixed text frames over a socketpair bound to stdin/stdout
+   • decoded frames can be handed over in an anonymous shared segment per
+     worker (memfd, passed with SCM_RIGHTS), so neither side encodes,
+     decodes or touches the disk, and a crash leaves no segment behind
+   • requests are grouped into batches of up to `batchSize` images
+   • per-image timeout; crashed or hung workers are killed and restarted
+   • thread-safe: concurrent callers share the free workers
+   • POSIX only; on other platforms start() fails and callers fall back
+
+=====================================================================*/
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "models/MaskSettings.hpp"
+
+struct MaskRequest
+{
+    std::string inPath;
+    std::string outPath;
+    MaskSettings settings;
+};
+
+// Decoded frame for the shared-memory path. `mask` must hold width*height bytes (continuous CV_8U);
+// it is only written when the request succeeds.
+struct MaskBufferRequest
+{
+    const unsigned char* bgr {nullptr};
+    int width {0};
+    int height {0};
+    size_t step {0};                     // bytes per BGR row
+    unsigned char* mask {nullptr};
+    MaskSettings settings;
+};
+
+class MaskWorkerPool
+{
+public:
+    struct Options
+    {
+        std::string python {"python3"};
+        std::string script;              // path to sam2_vehicle_mask.py
+        int workers {2};
+        int batchSize {4};
+        int timeoutMs {60000};           // per image in a batch
+        int maxRestarts {3};             // per worker slot
+        bool allowHeuristic {false};     // serve the script's heuristic when SAM2 is not configured
+    };
+
+    explicit MaskWorkerPool(Options options);
+    ~MaskWorkerPool();
+    MaskWorkerPool(const MaskWorkerPool&) = delete;
+    MaskWorkerPool& operator=(const MaskWorkerPool&) = delete;
+
+    // Spawns the workers and waits for their handshake. False if none became ready.
+    bool start();
+    bool ready() const { return readyCount_ > 0; }
+    const std::string& backend() const { return backend_; } // "sam2" / "heuristic" after start()
+    bool sharedMemory() const { return sharedMemory_; }      // workers accept runBuffers()
+    const Options& options() const { return opt_; }
+
+    // Runs every request; result[i] is true when the worker wrote reqs[i].outPath.
+    std::vector<bool> run(const std::vector<MaskRequest>& reqs);
+
+    // Same for in-memory frames; all false when sharedMemory() is false.
+    std::vector<bool> runBuffers(const std::vector<MaskBufferRequest>& reqs);
+
+    // Process-wide pool for `script`, configured from SAM2_WORKERS / SAM2_BATCH / SAM2_TIMEOUT_MS /
+    // SAM2_ALLOW_HEURISTIC. Returns nullptr if the workers cannot start (e.g. SAM2 not configured).
+    static MaskWorkerPool* shared(const std::string& script);
+
+private:
+    struct Worker;
+
+    bool spawn(Worker& w);
+    void kill(Worker& w);
+    bool exchange(Worker& w, const std::string& msg, unsigned long long id, size_t count,
+                  std::vector<std::string>& replies, int passFd = -1);
+    bool runBatch(Worker& w, const MaskRequest* reqs, size_t count, std::vector<char>& out, size_t offset);
+    bool ensureSegment(Worker& w, size_t bytes);
+    bool runBufferBatch(Worker& w, const MaskBufferRequest* reqs, size_t count, std::vector<char>& out, size_t offset);
+    void dispatch(size_t total, const std::function<bool(Worker&, size_t, size_t)>& batch);
+    Worker* acquire();
+    void release(Worker* w);
+
+    Options opt_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::mutex mutex_;
+    std::condition_variable freeCv_;
+    std::atomic<int> readyCount_ {0};
+    std::atomic<unsigned long long> nextId_ {1};
+    std::string backend_;
+    std::atomic<bool> sharedMemory_ {false};
+};
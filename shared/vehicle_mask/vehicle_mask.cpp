@@ -1,8 +1,13 @@
 #include "vehicle_mask.hpp"
+#include "mask_cache.hpp"
+#include "mask_io.hpp"
+#include "mask_worker_pool.hpp"
+#include "util/ImageOps.hpp"
 #include <opencv2/opencv.hpp>
 #include <filesystem>
 #include <cstdlib>
 #include <iostream>
+#include <vector>
 
 using namespace cv;
 
@@ -22,131 +27,541 @@ namespace {
         return std::clamp(thr, 200, 255);
     }
 
-    // Heuristic mask generator with settings (from file path)
-    bool heuristicMask(const std::string& inPath, const std::string& outPath, const MaskSettings& s)
+    // N dilations (erosions) with a k x k ellipse grow (shrink) the mask by about N*(k/2) px, so threshold the
+    // exact Euclidean distance to the nearest background (foreground) pixel instead: linear in pixels whatever
+    // the radius. The +0.5 matches the rounded rows of getStructuringElement's ellipse. As with cv::dilate/erode,
+    // pixels outside the image count as neither foreground nor background.
+    void distanceMorph(cv::Mat& mask, int radius, bool dilate)
+    {
+        if (radius <= 0) return;
+        cv::Mat src, dist;
+        if (dilate) cv::bitwise_not(mask, src); else src = mask;
+        cv::distanceTransform(src, dist, cv::DIST_L2, cv::DIST_MASK_PRECISE, CV_32F);
+        cv::threshold(dist, dist, radius + 0.5, 255, dilate ? cv::THRESH_BINARY_INV : cv::THRESH_BINARY);
+        dist.convertTo(mask, CV_8U);
+    }
+
+    // Writes a mask output in `format`; cutouts decode the source when the caller has no frame
+    bool writeOutput(const std::string& outPath, const Mat& mask, MaskFormat format, const Mat& img, const std::string& inPath)
+    {
+        std::filesystem::create_directories(std::filesystem::path(outPath).parent_path());
+        if (format == MaskFormat::AlphaPng || format == MaskFormat::AlphaWebp)
+        {
+            const Mat src = img.empty() ? imread(inPath) : img;
+            return writeMask(outPath, mask, format, &src);
+        }
+        return writeMask(outPath, mask, format);
+    }
+
+    // Only an 8-bit PNG output is byte-for-byte what the cache holds, so only that one is copied in
+    std::string cacheablePath(const std::string& outPath, MaskFormat format)
+    {
+        return format == MaskFormat::Png8 ? outPath : std::string();
+    }
+
+    // Heuristic mask generator with settings (from file path); cached under `cacheKey`
+    bool heuristicMask(const std::string& inPath, const std::string& outPath, const MaskSettings& s,
+                       const std::string& cacheKey, MaskFormat format)
     {
         Mat img = imread(inPath);
         if (img.empty()) return false;
         Mat mask;
         if (!computeVehicleMaskMat(img, mask, s)) return false;
-        return imwrite(outPath, mask);
+        if (!writeOutput(outPath, mask, format, img, inPath)) return false;
+        maskcache::store(cacheKey, s, maskcache::kHeuristic, mask, cacheablePath(outPath, format));
+        return true;
+    }
+
+    // Cached mask for `img` (decoded from the keyed file); a size mismatch counts as a miss
+    bool loadCachedMat(const std::string& key, const Mat& img, const MaskSettings& s, const std::string& backend, Mat& mask)
+    {
+        Mat cached;
+        if (!maskcache::load(key, s, backend, cached) || cached.size() != img.size()) return false;
+        mask = cached;
+        return true;
     }
 }
 
-bool generateVehicleMask(const std::string& inPath, const std::string& outPath)
-{
-    // Prefer external SAM2 script if present (no custom settings)
-    const char* scriptEnv = std::getenv("SAM2_MASK_SCRIPT");
-    std::string scriptPath = scriptEnv ? std::string(scriptEnv) : std::string("scripts/sam2_vehicle_mask.py");
-    if (fileExists(scriptPath))
+namespace {
+    std::string maskScriptPath()
+    {
+        const char* scriptEnv = std::getenv("SAM2_MASK_SCRIPT");
+        return scriptEnv ? std::string(scriptEnv) : std::string("scripts/sam2_vehicle_mask.py");
+    }
+
+    // One-shot script invocation, used when the worker pool is disabled (SAM2_WORKERS=0) or cannot start.
+    // `settings` null = script defaults (legacy overload).
+    bool runMaskScript(const std::string& scriptPath, const std::string& inPath, const std::string& outPath,
+                       const MaskSettings* settings)
     {
-        // Ensure output directory exists
-        std::filesystem::create_directories(std::filesystem::path(outPath).parent_path());
         std::string cmd = "python3 \"" + scriptPath + "\" --input \"" + inPath + "\" --output \"" + outPath + "\"";
+        if (settings)
+        {
+            auto toStr = [](int v){ return std::to_string(v); };
+            cmd += " --canny-low " + toStr(settings->cannyLow) +
+                " --canny-high " + toStr(settings->cannyHigh) +
+                " --kernel " + toStr(std::max(1, settings->morphKernel|1)) +
+                " --dilate " + toStr(settings->dilateIters) +
+                " --erode " + toStr(settings->erodeIters) +
+                (settings->fastMorphology ? std::string(" --fast-morph") : std::string()) +
+                (settings->useWhiteCycAssist ? std::string(" --white-cyc") : std::string()) +
+                " --white-thr " + toStr(settings->whiteThreshold) +
+                " --min-area " + toStr(settings->minArea) +
+                " --feather " + toStr(settings->featherRadius) +
+                (settings->invert ? std::string(" --invert") : std::string()) +
+                " --working-size " + toStr(settings->workingSize) +
+                (settings->restrictToForeground ? std::string(" --restrict-fg") : std::string());
+        }
         int rc = std::system(cmd.c_str());
         if (rc == 0 && fileExists(outPath)) return true;
         std::cerr << "[generateVehicleMask] SAM2 script failed (rc=" << rc << ") or output missing. Falling back to heuristic mask.\n";
+        return false;
     }
-    else
+
+    // Cache backend of masks from `pool`, or of one-shot script runs when it is null (those only succeed
+    // with SAM2). SAM2 masks are tagged with the model so switching models does not serve stale ones.
+    std::string scriptBackend(const MaskWorkerPool* pool)
     {
-        std::cerr << "[generateVehicleMask] SAM2 script not found at '" << scriptPath << "'. Using heuristic fallback.\n";
+        if (pool && pool->backend() != "sam2") return "script-" + pool->backend();
+        const char* model = std::getenv("SAM2_MODEL");
+        return "sam2-" + maskcache::textKey(model ? model : "");
     }
-    return heuristicMask(inPath, outPath, MaskSettings{});
-}
 
-bool generateVehicleMask(const std::string& inPath, const std::string& outPath, const MaskSettings& settings)
-{
-    const char* scriptEnv = std::getenv("SAM2_MASK_SCRIPT");
-    std::string scriptPath = scriptEnv ? std::string(scriptEnv) : std::string("scripts/sam2_vehicle_mask.py");
-    if (fileExists(scriptPath))
+    std::vector<bool> scriptMasks(const std::vector<MaskRequest>& reqs, const std::vector<std::string>& keys,
+                                  bool scriptDefaults)
     {
-        std::filesystem::create_directories(std::filesystem::path(outPath).parent_path());
-        auto toStr = [](int v){ return std::to_string(v); };
-        std::string cmd = std::string("python3 \"") + scriptPath + "\"" +
-            " --input \"" + inPath + "\"" +
-            " --output \"" + outPath + "\"" +
-            " --canny-low " + toStr(settings.cannyLow) +
-            " --canny-high " + toStr(settings.cannyHigh) +
-            " --kernel " + toStr(std::max(1, settings.morphKernel|1)) +
-            " --dilate " + toStr(settings.dilateIters) +
-            " --erode " + toStr(settings.erodeIters) +
-            (settings.useWhiteCycAssist ? std::string(" --white-cyc") : std::string()) +
-            " --white-thr " + toStr(settings.whiteThreshold) +
-            " --min-area " + toStr(settings.minArea) +
-            " --feather " + toStr(settings.featherRadius) +
-            (settings.invert ? std::string(" --invert") : std::string());
-        int rc = std::system(cmd.c_str());
-        if (rc == 0 && fileExists(outPath)) return true;
-        std::cerr << "[generateVehicleMask] SAM2 script failed (rc=" << rc << ") or output missing. Falling back to heuristic mask.\n";
+        std::vector<bool> done(reqs.size(), false);
+        const std::string scriptPath = maskScriptPath();
+        if (!fileExists(scriptPath))
+        {
+            std::cerr << "[generateVehicleMask] SAM2 script not found at '" << scriptPath << "'. Using heuristic fallback.\n";
+            return done;
+        }
+        for (const auto& r : reqs)
+            std::filesystem::create_directories(std::filesystem::path(r.outPath).parent_path());
+
+        if (MaskWorkerPool* pool = MaskWorkerPool::shared(scriptPath))
+        {
+            done = pool->run(reqs);
+            for (size_t i = 0; i < reqs.size(); ++i)
+            {
+                if (done[i] && !fileExists(reqs[i].outPath)) done[i] = false;
+                if (done[i]) maskcache::storeFile(keys[i], reqs[i].settings, scriptBackend(pool), reqs[i].outPath);
+            }
+            return done;
+        }
+        // Pool disabled, or the script does not speak the worker protocol: one process per image
+        for (size_t i = 0; i < reqs.size(); ++i)
+        {
+            done[i] = runMaskScript(scriptPath, reqs[i].inPath, reqs[i].outPath, scriptDefaults ? nullptr : &reqs[i].settings);
+            if (done[i]) maskcache::storeFile(keys[i], reqs[i].settings, scriptBackend(nullptr), reqs[i].outPath);
+        }
+        return done;
     }
-    else
+
+    MaskWorkerPool* scriptPool()
+    {
+        const std::string scriptPath = maskScriptPath();
+        return fileExists(scriptPath) ? MaskWorkerPool::shared(scriptPath) : nullptr;
+    }
+
+    // Decoded frames go to the workers through shared memory; failed entries are left empty
+    std::vector<Mat> scriptMaskMats(MaskWorkerPool& pool, const std::vector<Mat>& imgs, const MaskSettings& s)
+    {
+        std::vector<Mat> masks(imgs.size()), bufs(imgs.size());
+        std::vector<MaskBufferRequest> reqs;
+        std::vector<size_t> index;
+        for (size_t i = 0; i < imgs.size(); ++i)
+        {
+            if (imgs[i].empty() || imgs[i].type() != CV_8UC3) continue;
+            bufs[i].create(imgs[i].size(), CV_8U);
+            reqs.push_back(MaskBufferRequest{ imgs[i].data, imgs[i].cols, imgs[i].rows, imgs[i].step, bufs[i].data, s });
+            index.push_back(i);
+        }
+        const std::vector<bool> ok = pool.runBuffers(reqs);
+        for (size_t k = 0; k < index.size(); ++k)
+            if (ok[k]) masks[index[k]] = bufs[index[k]];
+        return masks;
+    }
+
+    // Path requests over shared memory: one decode and one PNG encode here, none in the script.
+    // Images are decoded a pool's worth at a time to bound memory on large frames.
+    std::vector<bool> bufferMasks(MaskWorkerPool& pool, const std::vector<std::pair<std::string, std::string>>& items,
+                                  const std::vector<std::string>& keys, const MaskSettings& scriptSettings,
+                                  const MaskSettings& fallback, MaskFormat format)
     {
-        std::cerr << "[generateVehicleMask] SAM2 script not found at '" << scriptPath << "'. Using heuristic fallback.\n";
+        std::vector<bool> done(items.size(), false);
+        const size_t chunk = static_cast<size_t>(std::max(1, pool.options().workers * pool.options().batchSize));
+        for (size_t base = 0; base < items.size(); base += chunk)
+        {
+            const size_t n = std::min(chunk, items.size() - base);
+            std::vector<Mat> imgs(n);
+            for (size_t i = 0; i < n; ++i) imgs[i] = imread(items[base + i].first);
+            std::vector<Mat> masks = scriptMaskMats(pool, imgs, scriptSettings);
+            for (size_t i = 0; i < n; ++i)
+            {
+                if (imgs[i].empty()) continue;
+                const bool scripted = !masks[i].empty();
+                if (!scripted && !computeVehicleMaskMat(imgs[i], masks[i], fallback)) continue;
+                const std::string& outPath = items[base + i].second;
+                done[base + i] = writeOutput(outPath, masks[i], format, imgs[i], items[base + i].first);
+                if (done[base + i])
+                    maskcache::store(keys[base + i], scripted ? scriptSettings : fallback,
+                                     scripted ? scriptBackend(&pool) : std::string(maskcache::kHeuristic), masks[i],
+                                     cacheablePath(outPath, format));
+            }
+        }
+        return done;
+    }
+
+    // Serves an output from the cache. While the workers run only their backend qualifies; otherwise a
+    // one-shot SAM2 mask is preferred and the in-process heuristic is what a miss would fall back to.
+    bool loadCachedFile(const std::string& key, const MaskWorkerPool* pool, const MaskSettings& scriptSettings,
+                        const MaskSettings& fallback, const std::pair<std::string, std::string>& item, MaskFormat format)
+    {
+        if (key.empty()) return false;
+        auto serve = [&](const MaskSettings& s, const std::string& backend)
+        {
+            if (format == MaskFormat::Png8) return maskcache::loadTo(key, s, backend, item.second);
+            Mat mask;
+            return maskcache::load(key, s, backend, mask) && writeOutput(item.second, mask, format, Mat(), item.first);
+        };
+        if (serve(scriptSettings, scriptBackend(pool))) return true;
+        return !pool && serve(fallback, maskcache::kHeuristic);
+    }
+
+    // File-to-file masks: mask cache, then the workers (shared memory or paths) or one-shot script, then
+    // the heuristic. `scriptSettings` go to the script, `fallback` to the heuristic.
+    std::vector<bool> maskFiles(const std::vector<std::pair<std::string, std::string>>& items,
+                                const MaskSettings& scriptSettings, const MaskSettings& fallback, bool scriptDefaults,
+                                MaskFormat format)
+    {
+        MaskWorkerPool* pool = scriptPool();
+        std::vector<bool> done(items.size(), false);
+        std::vector<std::pair<std::string, std::string>> todo;
+        std::vector<std::string> keys;
+        std::vector<size_t> index;
+        for (size_t i = 0; i < items.size(); ++i)
+        {
+            const std::string key = maskcache::fileKey(items[i].first);
+            if (loadCachedFile(key, pool, scriptSettings, fallback, items[i], format)) { done[i] = true; continue; }
+            todo.push_back(items[i]);
+            keys.push_back(key);
+            index.push_back(i);
+        }
+        if (todo.empty()) return done;
+
+        std::vector<bool> computed;
+        if (pool && pool->sharedMemory())
+        {
+            computed = bufferMasks(*pool, todo, keys, scriptSettings, fallback, format);
+        }
+        else
+        {
+            // The script writes 8-bit PNGs; other formats are converted from a temporary one
+            const bool direct = format == MaskFormat::Png8;
+            std::vector<MaskRequest> reqs;
+            for (const auto& it : todo)
+                reqs.push_back(MaskRequest{ it.first, direct ? it.second : it.second + ".script.png", scriptSettings });
+            computed = scriptMasks(reqs, keys, scriptDefaults);
+            for (size_t k = 0; k < todo.size(); ++k)
+            {
+                if (computed[k] && !direct)
+                {
+                    const Mat mask = imread(reqs[k].outPath, IMREAD_GRAYSCALE);
+                    computed[k] = !mask.empty() && writeOutput(todo[k].second, mask, format, Mat(), todo[k].first);
+                    std::error_code ec;
+                    std::filesystem::remove(reqs[k].outPath, ec);
+                }
+                if (!computed[k]) computed[k] = heuristicMask(todo[k].first, todo[k].second, fallback, keys[k], format);
+            }
+        }
+        for (size_t k = 0; k < index.size(); ++k) done[index[k]] = computed[k];
+        return done;
     }
-    return heuristicMask(inPath, outPath, settings);
 }
 
-bool computeVehicleMaskMat(const cv::Mat& img, cv::Mat& outMask, const MaskSettings& s)
+bool generateVehicleMask(const std::string& inPath, const std::string& outPath)
 {
-    if (img.empty()) return false;
-    cv::Mat gray; cv::cvtColor(img, gray, cv::COLOR_BGR2GRAY);
-    cv::medianBlur(gray, gray, 5);
+    // Without explicit settings the script runs with its own defaults (no white cyc assist)
+    MaskSettings scriptDefaults;
+    scriptDefaults.useWhiteCycAssist = false;
+    return maskFiles({ { inPath, outPath } }, scriptDefaults, MaskSettings{}, true, MaskFormat::Png8)[0];
+}
+
+bool generateVehicleMask(const std::string& inPath, const std::string& outPath, const MaskSettings& settings)
+{
+    return maskFiles({ { inPath, outPath } }, settings, settings, false, MaskFormat::Png8)[0];
+}
 
-    // White cyc assistance: identify non-white regions
-    cv::Mat nonWhiteMask;
-    if (s.useWhiteCycAssist)
+bool generateVehicleMaskMat(const cv::Mat& img, cv::Mat& outMask, const MaskSettings& settings,
+                            const std::string& sourcePath)
+{
+    if (img.empty()) return false;
+    MaskWorkerPool* pool = scriptPool();
+    const bool scripted = pool && pool->sharedMemory();
+    const std::string key = sourcePath.empty() ? std::string() : maskcache::fileKey(sourcePath);
+    if (!key.empty() && loadCachedMat(key, img, settings, scripted ? scriptBackend(pool) : std::string(maskcache::kHeuristic), outMask))
+        return true;
+    if (scripted)
     {
-        int wthr = (s.whiteThreshold >= 0 && s.whiteThreshold <= 255) ? s.whiteThreshold : autoWhiteThreshold(img);
-        cv::threshold(gray, nonWhiteMask, wthr, 255, cv::THRESH_BINARY_INV);
+        std::vector<Mat> masks = scriptMaskMats(*pool, { img }, settings);
+        if (!masks[0].empty())
+        {
+            outMask = masks[0];
+            maskcache::store(key, settings, scriptBackend(pool), outMask);
+            return true;
+        }
     }
+    if (!computeVehicleMaskMat(img, outMask, settings)) return false;
+    maskcache::store(key, settings, maskcache::kHeuristic, outMask);
+    return true;
+}
 
-    // Edges
-    cv::Mat edges; cv::Canny(gray, edges, std::min(s.cannyLow, s.cannyHigh), std::max(s.cannyLow, s.cannyHigh));
+bool cachedVehicleMaskMat(const std::string& sourcePath, const cv::Mat& img, cv::Mat& outMask, const MaskSettings& settings,
+                          bool store)
+{
+    if (img.empty()) return false;
+    const std::string key = maskcache::fileKey(sourcePath);
+    if (!key.empty() && loadCachedMat(key, img, settings, maskcache::kHeuristic, outMask)) return true;
+    if (!computeVehicleMaskMat(img, outMask, settings)) return false;
+    if (store) maskcache::store(key, settings, maskcache::kHeuristic, outMask);
+    return true;
+}
 
-    // Combine
-    cv::Mat mask;
-    if (!nonWhiteMask.empty()) cv::bitwise_or(edges, nonWhiteMask, mask);
-    else mask = edges;
+std::vector<bool> generateVehicleMasks(const std::vector<std::pair<std::string, std::string>>& items,
+                                       const MaskSettings& settings, MaskFormat format)
+{
+    return maskFiles(items, settings, settings, false, format);
+}
+
+namespace {
+// ---- mask stages ---------------------------------------------------------------------------------
+// Each stage reads its inputs without modifying them, so VehicleMaskPipeline can keep every result.
+
+// Grey + median blur: depends on the image only
+void stageMedian(const cv::Mat& img, cv::Mat& median)
+{
+    cv::cvtColor(img, median, cv::COLOR_BGR2GRAY);
+    cv::medianBlur(median, median, 5);
+}
+
+// Canny edges: cannyLow, cannyHigh
+void stageEdges(const cv::Mat& median, const MaskSettings& s, cv::Mat& edges)
+{
+    cv::Canny(median, edges, std::min(s.cannyLow, s.cannyHigh), std::max(s.cannyLow, s.cannyHigh));
+}
+
+// White cyc assistance, non-white regions: useWhiteCycAssist, whiteThreshold (empty when off)
+void stageNonWhite(const cv::Mat& img, const cv::Mat& median, const MaskSettings& s, cv::Mat& nonWhite)
+{
+    nonWhite.release();
+    if (!s.useWhiteCycAssist) return;
+    int wthr = (s.whiteThreshold >= 0 && s.whiteThreshold <= 255) ? s.whiteThreshold : autoWhiteThreshold(img);
+    cv::threshold(median, nonWhite, wthr, 255, cv::THRESH_BINARY_INV);
+}
+
+// Combine + morphology: morphKernel, dilateIters, erodeIters, fastMorphology
+void stageMorph(const cv::Mat& edges, const cv::Mat& nonWhite, const MaskSettings& s, cv::Mat& mask)
+{
+    if (!nonWhite.empty()) cv::bitwise_or(edges, nonWhite, mask);
+    else mask = edges.clone();
 
-    // Morphology
     int k = std::max(1, s.morphKernel | 1); // force odd
-    cv::Mat kernel = cv::getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(k, k));
-    if (s.dilateIters > 0) cv::dilate(mask, mask, kernel, cv::Point(-1,-1), s.dilateIters);
-    if (s.erodeIters > 0) cv::erode(mask, mask, kernel, cv::Point(-1,-1), s.erodeIters);
+    if (s.fastMorphology)
+    {
+        distanceMorph(mask, s.dilateIters * (k / 2), true);
+        distanceMorph(mask, s.erodeIters * (k / 2), false);
+    }
+    else
+    {
+        cv::Mat kernel = cv::getStructuringElement(cv::MORPH_ELLIPSE, cv::Size(k, k));
+        if (s.dilateIters > 0) cv::dilate(mask, mask, kernel, cv::Point(-1,-1), s.dilateIters);
+        if (s.erodeIters > 0) cv::erode(mask, mask, kernel, cv::Point(-1,-1), s.erodeIters);
+    }
     cv::threshold(mask, mask, 1, 255, cv::THRESH_BINARY);
+}
 
-    // Remove small components
+// Remove small components and fill holes in linear passes: minArea
+//  1. 8-connected labels of the mask; a keep/drop LUT by area turns them into the background map
+//  2. 4-connected labels of that background
+//  3. background not connected to the (0,0) region is a hole -> 0; everything else 255
+// Same result as per-component setTo + floodFill from (0,0) on the inverse (if (0,0) is
+// foreground, that fill is a no-op and the output is the filtered mask itself).
+// `mask` may cover only `roi` of a `frame`-sized image whose remainder is background: each side with
+// pixels outside the ROI gets a one-pixel background border standing in for that strip, which
+// connects exactly like the strip does, and the strips are then written from their border's label.
+void stageFill(const cv::Mat& mask, const MaskSettings& s, const cv::Rect& roi, const cv::Size& frame, cv::Mat& filled)
+{
+    const int t = roi.y > 0, l = roi.x > 0;
+    const int b = roi.br().y < frame.height, r = roi.br().x < frame.width;
+    cv::Mat canvas(mask.rows + t + b, mask.cols + l + r, CV_8U, cv::Scalar(255));
+    cv::Mat bg = canvas(cv::Rect(l, t, mask.cols, mask.rows));
     if (s.minArea > 0)
     {
         cv::Mat labels, stats, centroids;
         int n = cv::connectedComponentsWithStats(mask, labels, stats, centroids, 8, CV_32S);
-        cv::Mat filtered = cv::Mat::zeros(mask.size(), CV_8U);
+        std::vector<uchar> isBg(n, 255);
         for (int i = 1; i < n; ++i)
+            if (stats.at<int>(i, cv::CC_STAT_AREA) >= s.minArea) isBg[i] = 0;
+        for (int y = 0; y < mask.rows; ++y)
         {
-            if (stats.at<int>(i, cv::CC_STAT_AREA) >= s.minArea)
-            {
-                filtered.setTo(255, labels == i);
-            }
+            const int* lab = labels.ptr<int>(y);
+            uchar* pb = bg.ptr<uchar>(y);
+            for (int x = 0; x < mask.cols; ++x) pb[x] = isBg[lab[x]];
         }
-        mask = filtered;
     }
-
-    // Fill holes: flood fill from border on inverse and invert back
+    else
     {
-        cv::Mat inv; cv::bitwise_not(mask, inv);
-        cv::Mat ff = cv::Mat::zeros(inv.rows + 2, inv.cols + 2, CV_8U);
-        cv::floodFill(inv, ff, cv::Point(0,0), cv::Scalar(0));
-        cv::bitwise_not(inv, inv);
-        cv::bitwise_or(mask, inv, mask);
+        cv::threshold(mask, bg, 0, 255, cv::THRESH_BINARY_INV);
     }
 
-    // Feather edges then binarize
-    if (s.featherRadius > 0)
+    cv::Mat bgLabels;
+    cv::connectedComponents(canvas, bgLabels, 4, CV_32S);
+    const int seed = bgLabels.at<int>(0, 0); // 0 when (0,0) is foreground
+    auto value = [seed](int lab) -> uchar { return (lab == 0 || lab == seed) ? 255 : 0; };
+    filled.create(frame, CV_8U);
+    for (int y = 0; y < mask.rows; ++y)
     {
-        int rr = std::max(1, s.featherRadius * 2 + 1);
-        cv::GaussianBlur(mask, mask, cv::Size(rr, rr), 0);
-        cv::threshold(mask, mask, 127, 255, cv::THRESH_BINARY);
+        const int* lab = bgLabels.ptr<int>(y + t) + l;
+        uchar* m = filled.ptr<uchar>(y + roi.y) + roi.x;
+        for (int x = 0; x < mask.cols; ++x) m[x] = value(lab[x]);
     }
+    if (t) filled(cv::Rect(0, 0, frame.width, roi.y)).setTo(value(bgLabels.at<int>(0, l)));
+    if (b) filled(cv::Rect(0, roi.br().y, frame.width, frame.height - roi.br().y)).setTo(value(bgLabels.at<int>(canvas.rows - 1, l)));
+    if (l) filled(cv::Rect(0, roi.y, roi.x, roi.height)).setTo(value(bgLabels.at<int>(t, 0)));
+    if (r) filled(cv::Rect(roi.br().x, roi.y, frame.width - roi.br().x, roi.height)).setTo(value(bgLabels.at<int>(t, canvas.cols - 1)));
+}
+
+// ROI for MaskSettings::restrictToForeground: the non-white bounds of `img`, padded by everything that
+// can carry foreground outwards (median 2 px, Sobel 1 px, dilate and erode reach). Outside it a clean
+// white cyc can only ever be background. False when nothing is darker than `whiteThr`.
+bool foregroundRoi(const cv::Mat& img, int whiteThr, const MaskSettings& s, cv::Rect& roi)
+{
+    int top, bot, left, right;
+    if (!util::findForegroundBounds(img, top, bot, whiteThr) || !util::findForegroundBoundsX(img, left, right, whiteThr))
+        return false;
+    const int k = std::max(1, s.morphKernel | 1);
+    const int reach = (std::max(0, s.dilateIters) + std::max(0, s.erodeIters)) * (k / 2) + 4;
+    roi = cv::Rect(left - reach, top - reach, right - left + 1 + 2 * reach, bot - top + 1 + 2 * reach) &
+          cv::Rect(0, 0, img.cols, img.rows);
+    return true;
+}
+
+// Feather edges then binarize: featherRadius (shares the input when off)
+void stageFeather(const cv::Mat& mask, const MaskSettings& s, cv::Mat& out)
+{
+    if (s.featherRadius <= 0) { out = mask; return; }
+    int rr = std::max(1, s.featherRadius * 2 + 1);
+    cv::Mat blurred; // new buffer: `out` may share the input's
+    cv::GaussianBlur(mask, blurred, cv::Size(rr, rr), 0);
+    cv::threshold(blurred, blurred, 127, 255, cv::THRESH_BINARY);
+    out = blurred;
+}
+
+// Settings for the downscaled pass: areas scale by f^2, morphology radii by f (at least 1 px if set)
+MaskSettings scaledMaskSettings(const MaskSettings& s, double f)
+{
+    MaskSettings r = s;
+    const int radius = std::max(1, s.morphKernel | 1) / 2;
+    const int scaled = radius > 0 ? std::max(1, int(radius * f + 0.5)) : 0;
+    r.morphKernel = 2 * scaled + 1;
+    if (s.minArea > 0) r.minArea = std::max(1, int(s.minArea * f * f + 0.5));
+    return r;
+}
+
+// Fast guided filter (He & Sun): the linear model q = a*I + b is fitted at low resolution with the
+// low-res luminance as guide, then a and b are upsampled and applied to the full-res luminance so the
+// silhouette snaps to the real edges. Full-res cost is one bilinear resize pair and a multiply-add.
+void guidedUpsample(const cv::Mat& small, const cv::Mat& smallMask, const cv::Mat& full, cv::Mat& out)
+{
+    const cv::Size ks(5, 5);        // radius 2 at low res
+    const double eps = 1e-3;        // ~ (8/255)^2: flatter than this counts as one region
+    cv::Mat I, p;
+    cv::cvtColor(small, I, cv::COLOR_BGR2GRAY);
+    I.convertTo(I, CV_32F, 1.0 / 255.0);
+    smallMask.convertTo(p, CV_32F, 1.0 / 255.0);
+
+    cv::Mat meanI, meanP, corrI, corrIp;
+    cv::boxFilter(I, meanI, CV_32F, ks);
+    cv::boxFilter(p, meanP, CV_32F, ks);
+    cv::boxFilter(I.mul(I), corrI, CV_32F, ks);
+    cv::boxFilter(I.mul(p), corrIp, CV_32F, ks);
+    cv::Mat varI = corrI - meanI.mul(meanI);
+    cv::Mat covIp = corrIp - meanI.mul(meanP);
+    cv::Mat a = covIp / (varI + eps);
+    cv::Mat b = meanP - a.mul(meanI);
+    cv::boxFilter(a, a, CV_32F, ks);
+    cv::boxFilter(b, b, CV_32F, ks);
+
+    cv::Mat A, B, gray;
+    cv::resize(a, A, full.size(), 0, 0, cv::INTER_LINEAR);
+    cv::resize(b, B, full.size(), 0, 0, cv::INTER_LINEAR);
+    cv::cvtColor(full, gray, cv::COLOR_BGR2GRAY);
+    out.create(full.size(), CV_8U);
+    cv::parallel_for_(cv::Range(0, full.rows), [&](const cv::Range& range)
+    {
+        for (int y = range.start; y < range.end; ++y)
+        {
+            const float* pa = A.ptr<float>(y);
+            const float* pb = B.ptr<float>(y);
+            const uchar* g = gray.ptr<uchar>(y);
+            uchar* o = out.ptr<uchar>(y);
+            for (int x = 0; x < full.cols; ++x)
+                o[x] = (pa[x] * (g[x] * (1.0f / 255.0f)) + pb[x]) >= 0.5f ? 255 : 0;
+        }
+    });
+}
+
+// Working resolution for `s`: scale factor < 1 when the mask runs on a downscaled copy
+double workingScale(const cv::Mat& img, const MaskSettings& s)
+{
+    const int longEdge = std::max(img.cols, img.rows);
+    return (s.workingSize > 0 && longEdge > s.workingSize) ? double(s.workingSize) / longEdge : 1.0;
+}
+
+void downscale(const cv::Mat& img, double f, cv::Mat& small)
+{
+    // Silhouette is low-frequency: segment a downscaled copy, refine the edges at full res
+    const cv::Size smallSize(std::max(1, int(img.cols * f + 0.5)), std::max(1, int(img.rows * f + 0.5)));
+    cv::resize(img, small, smallSize, 0, 0, cv::INTER_AREA);
+}
+
+// Region the heavy stages run on (whole frame unless restrictToForeground finds bounds). Pins the white
+// threshold to the full-frame value so the cropped non-white stage matches the full-frame one.
+cv::Rect maskRoi(const cv::Mat& work, MaskSettings& ws)
+{
+    cv::Rect roi(0, 0, work.cols, work.rows);
+    if (!ws.restrictToForeground) return roi;
+    if (ws.whiteThreshold < 0 || ws.whiteThreshold > 255) ws.whiteThreshold = autoWhiteThreshold(work);
+    cv::Rect fg;
+    if (foregroundRoi(work, ws.whiteThreshold, ws, fg)) roi = fg;
+    return roi;
+}
+}
+
+bool computeVehicleMaskMat(const cv::Mat& img, cv::Mat& outMask, const MaskSettings& s)
+{
+    if (img.empty()) return false;
+    const double f = workingScale(img, s);
+    cv::Mat work = img;
+    if (f < 1.0) downscale(img, f, work);
+    MaskSettings ws = f < 1.0 ? scaledMaskSettings(s, f) : s;
+    const cv::Rect roi = maskRoi(work, ws);
+
+    cv::Mat median, edges, nonWhite, mask;
+    stageMedian(work(roi), median);
+    stageEdges(median, ws, edges);
+    stageNonWhite(work(roi), median, ws, nonWhite);
+    median.release();
+    stageMorph(edges, nonWhite, ws, mask);
+    edges.release(); nonWhite.release();
+    cv::Mat filled;
+    stageFill(mask, ws, roi, work.size(), filled);
+    if (f < 1.0) guidedUpsample(work, filled, img, mask);
+    else mask = filled;
+
+    stageFeather(mask, s, mask);
 
     // Invert if requested (object black, background white)
     if (s.invert) cv::bitwise_not(mask, mask);
@@ -154,3 +569,124 @@ bool computeVehicleMaskMat(const cv::Mat& img, cv::Mat& outMask, const MaskSetti
     outMask = mask;
     return true;
 }
+
+void vehicleMaskMorphology(const cv::Mat& mask, cv::Mat& out, const MaskSettings& s)
+{
+    cv::Mat morph;
+    stageMorph(mask, cv::Mat(), s, morph);
+    out = morph;
+}
+
+void vehicleMaskFill(const cv::Mat& mask, cv::Mat& out, const MaskSettings& s)
+{
+    cv::Mat filled;
+    stageFill(mask, s, cv::Rect(0, 0, mask.cols, mask.rows), mask.size(), filled);
+    out = filled;
+}
+
+void vehicleMaskFeather(const cv::Mat& mask, cv::Mat& out, const MaskSettings& s)
+{
+    stageFeather(mask, s, out);
+    if (out.data == mask.data) out = mask.clone();
+}
+
+bool postProcessVehicleMask(const cv::Mat& scores, cv::Mat& outMask, const MaskSettings& s, double threshold)
+{
+    if (scores.empty() || scores.channels() != 1) return false;
+    cv::Mat binary;
+    if (scores.depth() == CV_8U && threshold >= 0.0) cv::threshold(scores, binary, threshold, 255, cv::THRESH_BINARY);
+    else
+    {
+        cv::Mat f;
+        scores.convertTo(f, CV_32F);
+        cv::threshold(f, f, threshold, 255, cv::THRESH_BINARY);
+        f.convertTo(binary, CV_8U);
+    }
+    cv::Mat mask;
+    vehicleMaskFill(binary, mask, s);
+    stageFeather(mask, s, mask);
+    if (s.invert) cv::bitwise_not(mask, mask);
+    outMask = mask;
+    return true;
+}
+
+struct VehicleMaskPipeline::State
+{
+    bool valid {false};
+    MaskSettings last;
+    cv::Mat source;                  // shallow reference: keeps the buffer alive, so its address identifies the image
+    double scale {1.0};
+    cv::Rect roi;
+    cv::Mat work, median, edges, nonWhite, morph, filled, full, feathered;
+};
+
+VehicleMaskPipeline::VehicleMaskPipeline() : st_(new State) {}
+VehicleMaskPipeline::~VehicleMaskPipeline() = default;
+
+void VehicleMaskPipeline::clear() { st_.reset(new State); }
+
+const cv::Mat& VehicleMaskPipeline::image() const { return st_->source; }
+
+bool VehicleMaskPipeline::compute(const cv::Mat& img, cv::Mat& outMask, const MaskSettings& s)
+{
+    if (img.empty()) return false;
+    State& st = *st_;
+    const MaskSettings& o = st.last;
+    const bool sameImage = st.valid && st.source.data == img.data && st.source.size() == img.size() && st.source.type() == img.type();
+
+    // Each flag is "this stage's inputs changed"; a recomputed stage invalidates everything downstream
+    bool dirty = !sameImage || s.workingSize != o.workingSize;
+    if (dirty)
+    {
+        st.source = img;
+        st.scale = workingScale(img, s);
+        if (st.scale < 1.0) downscale(img, st.scale, st.work);
+        else st.work = img;
+    }
+    MaskSettings ws = st.scale < 1.0 ? scaledMaskSettings(s, st.scale) : s;
+    // The ROI only moves with the threshold or the morphology reach; a new ROI reruns everything
+    const bool roiDirty = dirty || s.restrictToForeground != o.restrictToForeground ||
+        (s.restrictToForeground && (s.whiteThreshold != o.whiteThreshold || s.morphKernel != o.morphKernel ||
+                                    s.dilateIters != o.dilateIters || s.erodeIters != o.erodeIters));
+    if (roiDirty)
+    {
+        const cv::Rect roi = maskRoi(st.work, ws);
+        dirty = dirty || roi != st.roi;
+        st.roi = roi;
+    }
+    else if (s.restrictToForeground && (ws.whiteThreshold < 0 || ws.whiteThreshold > 255))
+    {
+        ws.whiteThreshold = autoWhiteThreshold(st.work);
+    }
+    if (dirty) stageMedian(st.work(st.roi), st.median);
+
+    const bool edgesDirty = dirty || s.cannyLow != o.cannyLow || s.cannyHigh != o.cannyHigh;
+    const bool whiteDirty = dirty || s.useWhiteCycAssist != o.useWhiteCycAssist || s.whiteThreshold != o.whiteThreshold;
+    if (edgesDirty) stageEdges(st.median, ws, st.edges);
+    if (whiteDirty) stageNonWhite(st.work(st.roi), st.median, ws, st.nonWhite);
+
+    dirty = edgesDirty || whiteDirty || s.morphKernel != o.morphKernel || s.dilateIters != o.dilateIters ||
+            s.erodeIters != o.erodeIters || s.fastMorphology != o.fastMorphology;
+    if (dirty) stageMorph(st.edges, st.nonWhite, ws, st.morph);
+
+    dirty = dirty || s.minArea != o.minArea;
+    if (dirty)
+    {
+        st.filled.release();
+        stageFill(st.morph, ws, st.roi, st.work.size(), st.filled);
+        st.full.release(); // may share the previous filled/feathered buffer
+        if (st.scale < 1.0) guidedUpsample(st.work, st.filled, img, st.full);
+        else st.full = st.filled;
+    }
+
+    dirty = dirty || s.featherRadius != o.featherRadius;
+    if (dirty) stageFeather(st.full, s, st.feathered);
+
+    st.last = s;
+    st.valid = true;
+
+    // Fresh buffer either way so callers can't write into the cache
+    if (s.invert) cv::bitwise_not(st.feathered, outMask);
+    else outMask = st.feathered.clone();
+    return true;
+}
@@ -1,13 +1,67 @@
 #pragma once
+#include <memory>
 #include <string>
+#include <utility>
+#include <vector>
+#include "models/MaskFormat.hpp"
 #include "models/MaskSettings.hpp"
 namespace cv { class Mat; }
 
 // Generates a black-and-white vehicle mask for the input image and writes it to outPath (PNG recommended).
 // This attempts to use an external SAM2 Python script if available; otherwise, it falls back to a simple
 // OpenCV heuristic mask so the pipeline still works. Returns true on success.
+// The script runs in a persistent worker pool (see mask_worker_pool.hpp); SAM2_WORKERS=0 restores one process per image.
+// Outputs are served from the on-disk mask cache (mask_cache.hpp) when the same file was masked before.
 bool generateVehicleMask(const std::string& inPath, const std::string& outPath);
 bool generateVehicleMask(const std::string& inPath, const std::string& outPath, const MaskSettings& settings);
 
+// Batch form: {input, output} pairs are sent to the workers in batches; failures fall back per image.
+// Outputs are written in `format` (see mask_io.hpp); name them with maskFileSuffix(format).
+std::vector<bool> generateVehicleMasks(const std::vector<std::pair<std::string, std::string>>& items,
+                                       const MaskSettings& settings, MaskFormat format = MaskFormat::Png8);
+
 // Compute a vehicle mask directly from an input Mat (no disk I/O). Result is CV_8U {0,255}.
 bool computeVehicleMaskMat(const cv::Mat& img, cv::Mat& outMask, const MaskSettings& settings);
+
+// computeVehicleMaskMat through the mask cache, keyed by the file `img` was decoded from.
+// Interactive previews pass store = false: every tuning step would otherwise encode and write an entry.
+bool cachedVehicleMaskMat(const std::string& sourcePath, const cv::Mat& img, cv::Mat& outMask, const MaskSettings& settings,
+                          bool store = true);
+
+// The post-processing stages of computeVehicleMaskMat, on a CV_8U {0,255} mask (e.g. a model's output):
+//  morphology (morphKernel, dilate/erodeIters, fastMorphology), small-component removal + hole fill
+//  (minArea) and feather (featherRadius). Each writes a new buffer.
+void vehicleMaskMorphology(const cv::Mat& mask, cv::Mat& out, const MaskSettings& settings);
+void vehicleMaskFill(const cv::Mat& mask, cv::Mat& out, const MaskSettings& settings);
+void vehicleMaskFeather(const cv::Mat& mask, cv::Mat& out, const MaskSettings& settings);
+
+// Model scores/logits (single channel, any depth) -> final mask: score > threshold, then fill, feather and
+// invert exactly as computeVehicleMaskMat does. Morphology is left to the caller (vehicleMaskMorphology).
+bool postProcessVehicleMask(const cv::Mat& scores, cv::Mat& outMask, const MaskSettings& settings, double threshold = 0.0);
+
+// Script mask for an already-decoded BGR frame, handed over in shared memory (no encode/decode/disk);
+// falls back to computeVehicleMaskMat when the workers are unavailable or fail. With `sourcePath`
+// (the file `img` was decoded from) the mask cache is consulted first.
+bool generateVehicleMaskMat(const cv::Mat& img, cv::Mat& outMask, const MaskSettings& settings,
+                            const std::string& sourcePath = std::string());
+
+// Staged computeVehicleMaskMat for live tuning: keeps every intermediate stage
+// (grey+median, edges, non-white, morphology, components+fill, feather) and reruns only the stages
+// downstream of the MaskSettings fields that changed. Same output as computeVehicleMaskMat.
+// The image is identified by its buffer (held by reference); not thread-safe.
+class VehicleMaskPipeline
+{
+public:
+    VehicleMaskPipeline();
+    ~VehicleMaskPipeline();
+    VehicleMaskPipeline(const VehicleMaskPipeline&) = delete;
+    VehicleMaskPipeline& operator=(const VehicleMaskPipeline&) = delete;
+
+    bool compute(const cv::Mat& img, cv::Mat& outMask, const MaskSettings& settings);
+    const cv::Mat& image() const;   // last image passed to compute() (empty before the first call)
+    void clear();
+
+private:
+    struct State;
+    std::unique_ptr<State> st_;
+};